@@ -1,153 +1,288 @@
 #include <iostream>
-#include <stack>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <chrono>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include "../PDACore/pda_trace.h"
+#if !defined(_WIN32)
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 // === ANSI COLORS (The "Hacker" Look) ===
-const string RESET  = "\033[0m";
-const string RED    = "\033[31m";
-const string GREEN  = "\033[32m";
-const string YELLOW = "\033[33m";
-const string BLUE   = "\033[34m";
-const string CYAN   = "\033[36m";
-const string BOLD   = "\033[1m";
+// A cell's style is one byte; the renderer only emits a sequence when it changes.
+enum Style : uint8_t { PLAIN, RED, GREEN, YELLOW, BLUE, MAGENTA, CYAN, DIM, BOLD, BOLD_CYAN, BOLD_GREEN, STYLE_COUNT };
+const char* const STYLE_SEQ[STYLE_COUNT] = {
+    "\033[0m", "\033[0;31m", "\033[0;32m", "\033[0;33m", "\033[0;34m", "\033[0;35m", "\033[0;36m",
+    "\033[0;2m", "\033[0;1m", "\033[0;1;36m", "\033[0;1;32m",
+};
 
 // === VISUALIZATION HELPERS ===
+// Everything goes to the terminal in one write() per frame.
+void writeOut(const string& s) {
+    cout.flush();   // menu text still in the stream goes first
+#if defined(_WIN32)
+    fwrite(s.data(), 1, s.size(), stdout);
+    fflush(stdout);
+#else
+    size_t done = 0;
+    while (done < s.size()) {
+        ssize_t n = ::write(STDOUT_FILENO, s.data() + done, s.size() - done);
+        if (n <= 0) break;
+        done += size_t(n);
+    }
+#endif
+}
+
+void terminalSize(int& cols, int& rows) {
+    cols = getenv("COLUMNS") ? atoi(getenv("COLUMNS")) : 80;
+    rows = getenv("LINES") ? atoi(getenv("LINES")) : 24;
+#if !defined(_WIN32)
+    winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col && ws.ws_row) {
+        cols = ws.ws_col;
+        rows = ws.ws_row;
+    }
+#endif
+    if (cols < 40) cols = 40;
+    if (rows < 10) rows = 10;
+}
+
+// === SCREEN (double-buffered, differential) ===
+// A frame is composed into the back buffer of cells, then present() compares
+// it with what the terminal shows (the front buffer) and sends only the cells
+// that changed: a cursor move when they are not adjacent, a style sequence
+// when the style changes, then the characters. A packet step on the scenario
+// view rewrites a few dozen cells instead of the whole screen, with no clear
+// and so no flicker.
+class Screen {
+public:
+    Screen(int cols, int rows) : w(cols), h(rows), back(size_t(cols * rows)), front(size_t(cols * rows)) {}
+
+    int width() const { return w; }
+    int height() const { return h; }
+
+    void clear() {
+        for (Cell& c : back) c = Cell{};
+    }
+
+    // Text at (x, y), clipped to the screen; returns the column after it.
+    int put(int x, int y, string_view s, Style st = PLAIN) {
+        if (y < 0 || y >= h) return x + int(s.size());
+        for (char ch : s) {
+            if (x >= 0 && x < w) back[size_t(y * w + x)] = Cell{ ch, st };
+            x++;
+        }
+        return x;
+    }
+
+    void set(int x, int y, char ch, Style st) { back[size_t(y * w + x)] = Cell{ ch, st }; }
+
+    // The terminal was written behind our back (menus, prompts): repaint fully.
+    void invalidate() { full = true; }
+
+    // Returns the bytes sent.
+    size_t present() {
+        out.clear();
+        if (full) out += "\033[0m\033[2J";
+        int cx = -1, cy = -1;
+        uint8_t cur = STYLE_COUNT;
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                size_t i = size_t(y * w + x);
+                const Cell& c = back[i];
+                if (full ? c == Cell{} : c == front[i]) continue;   // a full repaint starts from a cleared screen
+                if (x != cx || y != cy) {
+                    out += "\033[";
+                    out += to_string(y + 1);
+                    out += ';';
+                    out += to_string(x + 1);
+                    out += 'H';
+                }
+                if (c.style != cur) {
+                    out += STYLE_SEQ[c.style];
+                    cur = c.style;
+                }
+                out += c.ch;
+                cx = x + 1;
+                cy = y;
+            }
+        }
+        if (!out.empty() || full) {
+            out += "\033[0m\033[";
+            out += to_string(h + 1);
+            out += ";1H";   // park the cursor under the frame
+        }
+        writeOut(out);
+        front = back;
+        full = false;
+        return out.size();
+    }
+
+private:
+    struct Cell {
+        char ch = ' ';
+        uint8_t style = PLAIN;
+        bool operator==(const Cell& o) const { return ch == o.ch && style == o.style; }
+    };
+
+    int w, h;
+    vector<Cell> back, front;
+    bool full = true;
+    string out;   // reused between frames
+};
+
+Screen screen(72, 24);   // the scenario view
+
 void clearScreen() {
     // ANSI escape code to clear screen and move cursor to top-left
     // This reduces flickering compared to system("cls")
     cout << "\033[2J\033[1;1H";
+    screen.invalidate();
 }
 
 void wait(int ms) {
     this_thread::sleep_for(chrono::milliseconds(ms));
 }
 
-// This function draws the entire UI frame
-void drawFrame(string packetName, int activeState, stack<string> s, string statusMsg, bool isAttack) {
-    clearScreen();
-    
+// This function composes the entire UI frame. Everything it shows comes from
+// one trace frame (state, stack top, stack depth), so a recorded step is drawn
+// without re-running the PDA.
+void drawFrame(const string& packetName, const TraceFile& trace, const TraceFrame& fr, const string& statusMsg, bool isAttack) {
+    const string RULE = "========================================================";
+    int activeState = fr.state;
+    int y = 0;
+    screen.clear();
+
     // 1. HEADER
-    cout << BOLD << CYAN << "========================================================" << RESET << endl;
-    cout << "   NETWORK PROTOCOL VALIDATOR (PDA VISUALIZER)   " << endl;
-    cout << BOLD << CYAN << "========================================================" << RESET << endl << endl;
+    screen.put(0, y++, RULE, BOLD_CYAN);
+    screen.put(0, y++, "   NETWORK PROTOCOL VALIDATOR (PDA VISUALIZER)   ");
+    screen.put(0, y++, RULE, BOLD_CYAN);
+    y++;
 
     // 2. STATE MACHINE DIAGRAM
     // Dynamic highlighting based on activeState (0=q0, 1=q1, 2=q2, 3=Trap)
-    string s0 = (activeState == 0) ? (GREEN + "[[ q0 ]]" + RESET) : " (q0) ";
-    string s1 = (activeState == 1) ? (BLUE + "[[ q1 ]]" + RESET) : " (q1) ";
-    string s2 = (activeState == 2) ? (GREEN + "[[ q2 ]]" + RESET) : " (q2) ";
-    string tr = (activeState == 3) ? (RED + "[[TRAP]]" + RESET) : " TRAP ";
-    
-    cout << "      Start           Tunnel           Closed" << endl;
-    cout << "     " << s0 << "=======>" << s1 << "=======>" << s2 << endl;
-    cout << "        |               |                |   " << endl;
-    cout << "        | (Bad Input)   | (Empty Stack)  | (Data after FIN)" << endl;
-    cout << "        V               V                V   " << endl;
-    cout << "      " << tr << "           " << tr << "           " << tr << endl << endl;
+    auto node = [&](int x, int row, int id, const char* on, const char* off, Style st) {
+        return activeState == id ? screen.put(x, row, on, st) : screen.put(x, row, off);
+    };
+    screen.put(0, y++, "      Start           Tunnel           Closed");
+    int x = screen.put(0, y, "     ");
+    x = node(x, y, 0, "[[ q0 ]]", " (q0) ", GREEN);
+    x = screen.put(x, y, "=======>");
+    x = node(x, y, 1, "[[ q1 ]]", " (q1) ", BLUE);
+    x = screen.put(x, y, "=======>");
+    node(x, y++, 2, "[[ q2 ]]", " (q2) ", GREEN);
+    screen.put(0, y++, "        |               |                |   ");
+    screen.put(0, y++, "        | (Bad Input)   | (Empty Stack)  | (Data after FIN)");
+    screen.put(0, y++, "        V               V                V   ");
+    x = screen.put(0, y, "      ");
+    for (int i = 0; i < 3; i++) {
+        x = node(x, y, 3, "[[TRAP]]", " TRAP ", RED);
+        x = screen.put(x, y, i < 2 ? "           " : "");
+    }
+    y += 2;
 
     // 3. PACKET INFO
-    string pktColor = isAttack ? RED : YELLOW;
-    cout << "  Current Packet:  " << pktColor << "[ " << packetName << " ]" << RESET << endl;
-    cout << "  System Status:   " << statusMsg << endl << endl;
+    x = screen.put(0, y, "  Current Packet:  ");
+    screen.put(x, y++, "[ " + packetName + " ]", isAttack ? RED : YELLOW);
+    x = screen.put(0, y, "  PDA State:       ");
+    screen.put(x, y++, trace.stateName(fr.state));
+    x = screen.put(0, y, "  System Status:   ");
+    screen.put(x, y++, statusMsg);
+    y++;
 
     // 4. STACK MEMORY VISUALIZATION
-    cout << "  " << BOLD << "STACK MEMORY:" << RESET << endl;
-    cout << "  +-------------+" << endl;
-
-    // Convert stack to vector for printing
-    vector<string> tempStack;
-    stack<string> dump = s;
-    while(!dump.empty()) {
-        tempStack.push_back(dump.top());
-        dump.pop();
-    }
+    screen.put(2, y++, "STACK MEMORY:", BOLD);
+    screen.put(0, y++, "  +-------------+");
 
-    if(tempStack.empty()) {
-        cout << "  |             |" << endl;
-        cout << "  |   " << RED << "EMPTY" << RESET << "     |" << endl;
-        cout << "  |             |" << endl;
+    // The top symbol, the entries under it, then the bottom marker
+    if(fr.depth == 0) {
+        screen.put(0, y++, "  |             |");
+        x = screen.put(0, y, "  |   ");
+        x = screen.put(x, y, "EMPTY", RED);
+        screen.put(x, y++, "     |");
+        screen.put(0, y++, "  |             |");
     } else {
-        for(const string& val : tempStack) {
-            if(val == "S")  cout << "  | " << BLUE << "[ SESSION ]" << RESET << " | <--- ACCESS TOKEN" << endl;
-            if(val == "Z0") cout << "  | [ BASE Z0 ] |" << endl;
+        if(fr.depth > 1) {
+            x = screen.put(0, y, "  | ");
+            if(fr.top == STK_TUNNEL)       screen.put(screen.put(x, y, "[ TUNNEL  ]", CYAN), y, " | <--- NESTED");
+            else if(fr.top == STK_SESSION) screen.put(screen.put(x, y, "[ SESSION ]", BLUE), y, " | <--- ACCESS TOKEN");
+            else {
+                string name(trace.stackName(fr.top));
+                name.resize(7, ' ');
+                screen.put(x, y, "[ " + name + " ] |");
+            }
+            y++;
         }
+        if(fr.depth > 2) screen.put(0, y++, "  | [   ...   ] | x" + to_string(fr.depth - 2) + " below");
+        screen.put(0, y++, "  | [ BASE " + string(trace.stackName(trace.initial().top)) + " ] |");
     }
-    cout << "  +-------------+" << endl;
-    cout << "\n========================================================" << endl;
+    screen.put(0, y++, "  +-------------+");
+    y++;
+    screen.put(0, y, RULE);
+    screen.present();
 }
 
 // === PDA LOGIC ===
-enum State { q0, q1, q2, qTrap };
+// Transitions come from the compiled PDA definition; these are the on-screen messages.
+PdaTable protocol;
+vector<string> statusMsg; // rule id -> message
+
+void loadStatusMessages() {
+    statusMsg = protocol.ruleTexts({
+        {"handshake",    "VALID: Handshake verified. Token Pushed."},
+        {"no_handshake", "VIOLATION: Protocol must start with SYN!"},
+        {"tunnel",       "VALID: Traffic inside Secure Tunnel."},
+        {"hijack",       "CRITICAL: Stack Empty! Session Hijack Attempt!"},
+        {"close",        "VALID: Session Teardown. Token Popped."},
+        {"reset",        "VALID: Session Reset. Token Popped."},
+        {"nested_open",  "VALID: Nested Tunnel opened. Token Pushed."},
+        {"nested_close", "VALID: Nested Tunnel closed. Token Popped."},
+        {"teardown",     "VALID: Closing ACK/FIN."},
+        {"after_close",  "INTRUSION: Data received after Connection Closed."},
+        {"blocked",      "Rejected."},
+    });
+}
+
+// Status messages by the trace's own rule ids; unknown rules show their name.
+vector<string> messagesFor(const TraceFile& trace) {
+    vector<string> out;
+    for (int r = 0; r < trace.header().rules; r++) {
+        string name(trace.ruleName(uint8_t(r)));
+        int id = protocol.ruleId(name);
+        out.push_back(id >= 0 ? statusMsg[id] : name);
+    }
+    return out;
+}
+
+// Animate one recorded flow straight from the trace columns.
+void replayFlow(const TraceFile& trace, uint64_t flow) {
+    vector<string> msg = messagesFor(trace);
 
-void runScenario(string title, vector<string> packets) {
-    stack<string> mem;
-    mem.push("Z0"); // Base of stack
-    State curr = q0;
-    
     clearScreen();
-    cout << "LOADING SCENARIO: " << title << "..." << endl;
+    cout << "LOADING SCENARIO: " << trace.flowName(flow) << "..." << endl;
     wait(1000);
 
-    for (const string& pkt : packets) {
-        bool isAttack = false;
-        string msg = "Processing...";
+    TraceFrame before = trace.initial();
+    for (uint64_t i = trace.begin(flow); i < trace.end(flow); i++) {
+        string pkt(trace.label(i));
 
         // A. ANIMATE PACKET ARRIVAL
-        drawFrame(pkt, curr, mem, "Incoming Traffic...", false);
+        drawFrame(pkt, trace, before, "Incoming Traffic...", false);
         wait(1000); // Pause to let user see the packet
 
-        // B. PROCESS LOGIC
-        
-        // 1. q0 -> q1 (Handshake)
-        if (curr == q0) {
-            if(pkt == "SYN") {
-                mem.push("S");
-                curr = q1;
-                msg = "VALID: Handshake verified. Token Pushed.";
-            } else {
-                curr = qTrap; isAttack = true;
-                msg = "VIOLATION: Protocol must start with SYN!";
-            }
-        }
-        // 2. q1 -> q1 or q2 (Tunnel)
-        else if (curr == q1) {
-            if (pkt == "FIN") {
-                // Normal Close
-                if (mem.top() == "S") {
-                    mem.pop();
-                    curr = q2;
-                    msg = "VALID: Session Teardown. Token Popped.";
-                }
-            } else {
-                // Data / ACK / HTTP / SSH etc.
-                if (mem.top() == "S") {
-                    curr = q1; // Stay in tunnel
-                    msg = "VALID: Traffic inside Secure Tunnel.";
-                } else {
-                    // HIJACK ATTEMPT (Stack Empty in q1)
-                    curr = qTrap; isAttack = true;
-                    msg = "CRITICAL: Stack Empty! Session Hijack Attempt!";
-                }
-            }
-        }
-        // 3. q2 -> Trap (Zombie Data)
-        else if (curr == q2) {
-            curr = qTrap; isAttack = true;
-            msg = "INTRUSION: Data received after Connection Closed.";
-        }
-        // 4. Already Trapped
-        else {
-            curr = qTrap; isAttack = true;
-            msg = "Rejected.";
-        }
+        // B. RECORDED RESULT
+        bool isAttack = trace.isTrap(trace.state(i));
+        before = trace.frame(i);
 
         // C. ANIMATE RESULT
-        drawFrame(pkt, curr, mem, msg, isAttack);
+        drawFrame(pkt, trace, before, msg[trace.rule(i)], isAttack);
         
         if(isAttack) {
             // Flash effect for attack
@@ -163,10 +298,180 @@ void runScenario(string title, vector<string> packets) {
     cin.ignore(); cin.get();
 }
 
-int main() {
+// Built-in scenarios run once into an in-memory trace, then replay like a file.
+void runScenario(string title, vector<string> packets) {
+    TraceWriter writer(protocol);
+    uint32_t flow = writer.addFlow(title);
+    PdaConfig pda;
+    protocol.reset(pda); // q0 with Z0 at the base of the stack
+    for (const string& pkt : packets) {
+        Symbol sym = classifyPacket(pkt);
+        PdaTransition t = protocol.step(pda, sym);
+        bool isAttack = protocol.isTrap(pda.state);
+        writer.step(flow, sym, t, pda, isAttack ? TRACE_ATTACK : 0, pkt);
+        if (isAttack) break;
+    }
+
+    ostringstream buf;
+    writer.write(buf);
+    string bytes = buf.str();
+    TraceFile trace;
+    string err;
+    if (trace.view(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size(), err)) replayFlow(trace, flow);
+}
+
+// --trace <file>: pick any flow of a recorded trace (e.g. CaptureValidator --trace).
+int browseTrace(const string& path) {
+    TraceFile trace;
+    string err;
+    if (!trace.open(path, err)) {
+        cerr << err << endl;
+        return 1;
+    }
+    while (true) {
+        clearScreen();
+        cout << STYLE_SEQ[BOLD_GREEN] << "=== TRACE: " << path << " ===" << STYLE_SEQ[PLAIN] << endl;
+        cout << trace.flows() << " flows, " << trace.steps() << " steps" << endl;
+        for (uint64_t f = 0; f < trace.flows() && f < 10; f++)
+            cout << (f + 1) << ". " << trace.flowName(f) << "  [" << verdictName(trace.verdict(f)) << ", "
+                 << (trace.end(f) - trace.begin(f)) << " steps]" << endl;
+        if (trace.flows() > 10) cout << "..." << endl;
+        cout << "\nFlow to replay [1-" << trace.flows() << ", 0 = exit]: ";
+
+        unsigned long long choice;
+        if (!(cin >> choice) || choice == 0) break;
+        if (choice <= trace.flows()) replayFlow(trace, choice - 1);
+    }
+    return 0;
+}
+
+// === WALL MODE ===
+// --wall <trace>: the recorded flows side by side, one cell each, all stepping
+// together one packet per frame. A cell shows its flow's state: '.' for the
+// start state, '#' for the trap, otherwise the state id (0-9a-z) in its own
+// color. Frames go through a Screen, so only the cells whose flow changed state
+// are sent and a full terminal of flows keeps up with 30-60 fps.
+struct WallOptions {
+    int fps = 30;
+    uint64_t from = 0;     // first flow shown
+    uint64_t frames = 0;   // 0 = until every shown flow has finished
+};
+
+char stateGlyph(const TraceFile& trace, uint8_t s) {
+    if (s == trace.initial().state) return '.';
+    if (trace.isTrap(s)) return '#';
+    return "0123456789abcdefghijklmnopqrstuvwxyz"[s % 36];
+}
+
+Style stateStyle(const TraceFile& trace, uint8_t s) {
+    static const Style palette[] = { GREEN, CYAN, BLUE, YELLOW, MAGENTA };
+    if (s == trace.initial().state) return DIM;
+    if (trace.isTrap(s)) return RED;
+    return palette[s % 5];
+}
+
+int wallTrace(const string& path, const WallOptions& opt) {
+    TraceFile trace;
+    string err;
+    if (!trace.open(path, err)) {
+        cerr << err << endl;
+        return 1;
+    }
+    if (opt.from >= trace.flows()) {
+        cerr << "--from: trace has " << trace.flows() << " flows" << endl;
+        return 1;
+    }
+
+    int cols, rows;
+    terminalSize(cols, rows);
+    const int HEADER = 3;
+    Screen wall(cols, rows - 1);   // the last line holds the parked cursor
+    uint64_t shown = min<uint64_t>(trace.flows() - opt.from, uint64_t(cols) * uint64_t(rows - 1 - HEADER));
+    int states = trace.header().states;
+    uint8_t start = trace.initial().state;
+
+    auto period = chrono::nanoseconds(1000000000LL / max(1, opt.fps));
+    auto next = chrono::steady_clock::now();
+    auto began = next;
+    chrono::nanoseconds busy{ 0 };
+    size_t bytes = 0;
+    uint64_t frame = 0;
+    vector<uint64_t> count(states);
+
+    clearScreen();
+    while (true) {
+        auto t0 = chrono::steady_clock::now();
+        fill(count.begin(), count.end(), 0);
+        uint64_t live = 0;
+
+        wall.clear();
+        for (uint64_t k = 0; k < shown; k++) {
+            uint64_t f = opt.from + k;
+            uint64_t b = trace.begin(f), e = trace.end(f);
+            uint8_t s = start;
+            if (frame > 0 && e > b) s = trace.state(min(b + frame, e) - 1);
+            if (b + frame < e) live++;
+            count[s]++;
+            wall.set(int(k % uint64_t(cols)), HEADER + int(k / uint64_t(cols)), stateGlyph(trace, s), stateStyle(trace, s));
+        }
+
+        ostringstream title;
+        title << "PDA WALL  " << path << "  flows " << (opt.from + 1) << "-" << (opt.from + shown) << " of " << trace.flows()
+              << "  step " << frame << "  live " << live << "  " << opt.fps << " fps";
+        wall.put(0, 0, title.str(), BOLD_CYAN);
+        int x = 0;
+        for (int s = 0; s < states; s++) {
+            if (!count[size_t(s)]) continue;
+            x = wall.put(x, 1, string(1, stateGlyph(trace, uint8_t(s))), stateStyle(trace, uint8_t(s)));
+            x = wall.put(x + 1, 1, string(trace.stateName(uint8_t(s))) + " " + to_string(count[size_t(s)]) + "  ");
+        }
+        bytes += wall.present();
+        busy += chrono::steady_clock::now() - t0;
+        frame++;
+
+        if (live == 0 || (opt.frames && frame >= opt.frames)) break;
+        next += period;
+        this_thread::sleep_until(next);
+    }
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - began).count();
+    cout << "Wall: " << frame << " frames of " << shown << " flows in " << secs << " s, "
+         << chrono::duration<double, micro>(busy).count() / double(frame) << " us per frame to compose and diff, "
+         << bytes / frame << " bytes per frame" << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    string err;
+    if (!protocol.load(pdaPathFromArgs(argc, argv), err)) {
+        cerr << err << endl;
+        return 1;
+    }
+    loadStatusMessages();
+    string wallPath;
+    WallOptions wall;
+    for (int i = 1; i + 1 < argc; i++) {
+        string a = argv[i];
+        if (a == "--trace") return browseTrace(argv[i + 1]);
+        if (a == "--wall") wallPath = argv[++i];
+        else if (a == "--fps") wall.fps = atoi(argv[++i]);
+        else if (a == "--from") {
+            char* end;
+            const char* v = argv[++i];
+            wall.from = strtoull(v, &end, 10);
+            if (*v < '1' || *v > '9' || *end) {   // 1-based: "0", "-1" and "x" would wrap below
+                cerr << "--from: expected a flow number from 1, got \"" << v << "\"" << endl;
+                return 1;
+            }
+            wall.from--;
+        }
+        else if (a == "--frames") wall.frames = strtoull(argv[++i], nullptr, 10);
+    }
+    if (!wallPath.empty()) return wallTrace(wallPath, wall);
+
     while(true) {
         clearScreen();
-        cout << BOLD << GREEN << "=== CYBERSECURITY PROTOCOL VISUALIZER ===" << RESET << endl;
+        cout << STYLE_SEQ[BOLD_GREEN] << "=== CYBERSECURITY PROTOCOL VISUALIZER ===" << STYLE_SEQ[PLAIN] << endl;
         cout << "1. Web Browsing (Valid Flow)" << endl;
         cout << "2. SSH Session (Valid Flow)" << endl;
         cout << "3. Session Hijack (Attack - Empty Stack)" << endl;
@@ -1,112 +1,103 @@
 #include <iostream>
-#include <stack>
 #include <vector>
 #include <string>
 #include <iomanip> // For nice formatting
+#include <string_view>
+#include <unordered_map>
+#include <cstdio>
+#include <chrono>
+#include <cerrno>
+#include "PDACore/pda_flows.h"
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 // === PDA CONFIGURATION ===
-enum State { q0_Listen, q1_Active, q2_Closed, qTrap_Reject };
+// The protocol is compiled from a definition (PDACore/protocols/tcp_handshake.pda
+// is built in); this file only decides how each state and rule is printed.
+PdaTable protocol;
+vector<string> actionLog; // rule id -> action text
+SignatureSet signatures;  // payload signatures, compiled into one minimized DFA
 
 // Helper to get state names
-string getStateName(State s) {
-    switch(s) {
-        case q0_Listen:   return "q0 (Listen)";
-        case q1_Active:   return "q1 (Active Session)";
-        case q2_Closed:   return "q2 (Closed)";
-        case qTrap_Reject:return "TRAP (REJECTED)";
-        default:          return "Unknown";
-    }
+string getStateName(uint8_t s) {
+    const string& n = protocol.states[s];
+    if (n == "q0")    return "q0 (Listen)";
+    if (n == "q1")    return "q1 (Active Session)";
+    if (n == "q2")    return "q2 (Closed)";
+    if (n == "qtrap") return "TRAP (REJECTED)";
+    return n;
 }
 
 // Function to simulate the PDA logic
-void runPDA(vector<string> packetStream, string testName) {
+void runPDA(const vector<string>& packetStream, const string& testName) {
     // THE MEMORY STACK (The difference between DFA and PDA)
-    stack<string> memoryStack;
-    memoryStack.push("Z0"); // Z0: Initial Bottom Marker
-    
-    State currentState = q0_Listen;
+    // Inline run-length stack of symbol IDs, Z0 (Initial Bottom Marker) already pushed
+    PdaConfig pda;
+    protocol.reset(pda);
+    uint16_t scan = 0;   // signature DFA state, carried from packet to packet
+    string lastRow;
+    size_t repeats = 0;
 
     cout << "\n===========================================================" << endl;
     cout << " SCENARIO: " << testName << endl;
     cout << "===========================================================" << endl;
-    cout << "START STATE: " << getStateName(currentState) << endl;
-    cout << "INIT STACK:  [ Z0 ]" << endl;
+    cout << "START STATE: " << getStateName(pda.state) << endl;
+    cout << "INIT STACK:  [ " << protocol.stackName(protocol.bottom) << " ]" << endl;
     cout << "-----------------------------------------------------------" << endl;
     cout << left << setw(15) << "INPUT" << " | " << setw(25) << "ACTION / LOGIC" << " | " << "NEW STATE" << endl;
     cout << "-----------------------------------------------------------" << endl;
 
     for (const string& packet : packetStream) {
-        string actionLog = "";
-        
         // --- PDA TRANSITION LOGIC ---
-        
-        // 1. STATE q0 (LISTEN)
-        if (currentState == q0_Listen) {
-            if (packet == "SYN") {
-                // Rule: Read SYN -> Push Session Token
-                memoryStack.push("SESSION_ID"); 
-                currentState = q1_Active;
-                actionLog = "PUSH 'SESSION_ID'";
-            } else {
-                // Rule: Anything else -> Reject (e.g. Nmap Scan)
-                currentState = qTrap_Reject;
-                actionLog = "VIOLATION: No Handshake";
-            }
-        }
-        
-        // 2. STATE q1 (ACTIVE TUNNEL)
-        else if (currentState == q1_Active) {
-            if (packet == "FIN") {
-                // Rule: Read FIN -> Pop Token -> Close
-                if (!memoryStack.empty() && memoryStack.top() == "SESSION_ID") {
-                    memoryStack.pop();
-                    currentState = q2_Closed;
-                    actionLog = "POP 'SESSION_ID'";
-                }
-            } 
-            else {
-                // Rule: Payload Agnostic (Accepts HTTP, SSH, ACK...)
-                // CRITICAL CHECK: Is the Session Token on the stack?
-                if (!memoryStack.empty() && memoryStack.top() == "SESSION_ID") {
-                    currentState = q1_Active; // Stay in Tunnel
-                    actionLog = "VERIFY Stack (OK)";
-                } else {
-                    // Hijack Attempt (State is q1, but Stack is missing Token)
-                    currentState = qTrap_Reject;
-                    actionLog = "ERROR: Stack Empty!";
-                }
+        // Classify the label once, then the engine only sees integer IDs
+        Symbol sym = classifyPacket(packet);
+        PdaTransition t = protocol.step(pda, sym);
+        string action = actionLog[t.rule];
+
+        // --- PAYLOAD INSPECTION ---
+        // Data the session accepts (q1) is no longer waved through: the label
+        // stands in for the payload and is fed to the signature DFA
+        if (sym == SYM_DATA && protocol.isInspected(pda.state)) {
+            int hit = signatures.inspect(scan, reinterpret_cast<const uint8_t*>(packet.data()), packet.size());
+            if (hit >= 0) {
+                pda.state = protocol.trap;
+                action = "SIGNATURE: " + signatures.names[hit];
             }
         }
-        
-        // 3. STATE q2 (CLOSED)
-        else if (currentState == q2_Closed) {
-            // Rule: Any data after close is an intrusion
-            currentState = qTrap_Reject;
-            actionLog = "INTRUSION: Data after Close";
-        }
-        
-        // 4. TRAP STATE
-        else {
-            currentState = qTrap_Reject;
-            actionLog = "Blocked";
-        }
 
-        // Print the Step Log
-        cout << left << setw(15) << packet << " | " << setw(25) << actionLog << " | " << getStateName(currentState) << endl;
+        if (pda.overflow) action = "OVERFLOW: Stack Full";
+
+        // Print the Step Log; a run of identical rows is printed once plus a count
+        string row = packet + " | " + action + " | " + getStateName(pda.state);
+        if (row == lastRow) {
+            repeats++;
+        } else {
+            if (repeats) cout << "  ... same again x" << repeats << endl;
+            repeats = 0;
+            lastRow = row;
+            cout << left << setw(15) << packet << " | " << setw(25) << action << " | " << getStateName(pda.state) << endl;
+        }
         
         // Stop simulation if trapped
-        if (currentState == qTrap_Reject) break;
+        if (protocol.isTrap(pda.state)) break;
     }
+    if (repeats) cout << "  ... same again x" << repeats << endl;
 
     cout << "-----------------------------------------------------------" << endl;
     
     // Final Verdict
-    if (currentState == q2_Closed) {
+    if (pda.overflow) {
+        cout << "[OVERFLOW] Nesting Exceeds the Stack. Flow Dropped." << endl;
+    }
+    else if (protocol.isAccepting(pda.state)) {
         cout << "[SUCCESS] Traffic Pattern Validated. Session Closed Cleanly." << endl;
     } 
-    else if (currentState == qTrap_Reject) {
+    else if (protocol.isTrap(pda.state)) {
         cout << "[ALERT]   Security Violation Detected. Packet Dropped." << endl;
     }
     else {
@@ -115,7 +106,304 @@ void runPDA(vector<string> packetStream, string testName) {
     cout << endl;
 }
 
-int main() {
+// === RFC 793 CONNECTION AUTOMATON ===
+// The same engine running the full connection life cycle (pda_tcp.h). Its input
+// is a captured segment: raw TCP flags byte plus direction, no labels at all.
+PdaTable connection;
+vector<string> connectionLog;
+
+struct Segment {
+    bool fromResponder;
+    uint8_t flags;
+    string payload;
+};
+
+string describeSegment(const Segment& seg) {
+    static const char* const NAMES[] = { "FIN", "SYN", "RST", "PSH", "ACK", "URG", "ECE", "CWR" };
+    string s;
+    for (int b = 0; b < 8; b++)
+        if (seg.flags & (1 << b)) s += (s.empty() ? "" : "+") + string(NAMES[b]);
+    return (seg.fromResponder ? "< " : "> ") + (s.empty() ? "none" : s);
+}
+
+void runSegments(const vector<Segment>& segments, const string& testName) {
+    PdaConfig pda;
+    connection.reset(pda);
+
+    cout << "\n===========================================================" << endl;
+    cout << " SCENARIO: " << testName << endl;
+    cout << "===========================================================" << endl;
+    cout << left << setw(15) << "SEGMENT" << " | " << setw(25) << "ACTION / LOGIC" << " | " << "NEW STATE" << endl;
+    cout << "-----------------------------------------------------------" << endl;
+    auto show = [&](const string& segment, const PdaTransition& t) {
+        cout << left << setw(15) << segment << " | " << setw(25) << connectionLog[t.rule] << " | "
+             << connection.states[pda.state] << endl;
+    };
+    for (const Segment& seg : segments) {
+        // One table lookup on [direction][payload][flags] gives the input symbol
+        Symbol sym = tcpInput(seg.flags, !seg.payload.empty(), seg.fromResponder);
+        // A FIN carrying data: the data first, then the FIN
+        Symbol data;
+        if (tcpSplitFin(sym, !seg.payload.empty(), data)) {
+            show(describeSegment(seg), connection.step(pda, data));
+            if (connection.isTrap(pda.state)) break;
+            show("  (then FIN)", connection.step(pda, sym));
+        } else {
+            show(describeSegment(seg), connection.step(pda, sym));
+        }
+        if (connection.isTrap(pda.state)) break;
+    }
+    cout << "-----------------------------------------------------------" << endl;
+    if (connection.isAccepting(pda.state)) cout << "[SUCCESS] Connection Closed Cleanly." << endl;
+    else if (connection.isTrap(pda.state)) cout << "[ALERT]   Security Violation Detected. Packet Dropped." << endl;
+    else cout << "[WARN]    Incomplete Session (Did not close)." << endl;
+    cout << endl;
+}
+
+// Validate several conversations whose packets arrive interleaved on the wire.
+// Each flow keeps its own PDA state in the flow table, so one pass is enough.
+void runInterleaved(const vector<vector<string>>& flows, const vector<string>& names, const string& testName) {
+    FlowValidator validator(protocol, flows.size());
+
+    cout << "\n===========================================================" << endl;
+    cout << " SCENARIO: " << testName << endl;
+    cout << "===========================================================" << endl;
+    cout << left << setw(6) << "FLOW" << setw(15) << "INPUT" << " | " << "NEW STATE" << endl;
+    cout << "-----------------------------------------------------------" << endl;
+
+    // Flow i is 10.0.0.(i+1):(40000+i) -> 192.168.1.10:443, packets dealt round-robin
+    size_t longest = 0;
+    for (const auto& f : flows) longest = max(longest, f.size());
+    for (size_t n = 0; n < longest; n++) {
+        for (size_t i = 0; i < flows.size(); i++) {
+            if (n >= flows[i].size()) continue;
+            FlowKey key = FlowKey::ipv4(0x0A000001 + uint32_t(i), 0xC0A8010A, uint16_t(40000 + i), 443);
+            bool alert = validator.onPacket(key, classifyPacket(flows[i][n]));
+            const FlowSlot* slot = validator.flows().find(key);
+            cout << left << setw(6) << ("#" + to_string(i + 1)) << setw(15) << flows[i][n] << " | "
+                 << getStateName(slot->pda.state) << (alert ? "   <-- ALERT" : "") << endl;
+        }
+    }
+
+    cout << "-----------------------------------------------------------" << endl;
+    vector<Verdict> verdicts(flows.size());
+    validator.finish([&](const FlowSlot& s, Verdict v) { verdicts[s.key.sport - 40000] = v; });
+    for (size_t i = 0; i < flows.size(); i++)
+        cout << "[" << left << setw(7) << verdictName(verdicts[i]) << "] #" << (i + 1) << " " << names[i] << endl;
+
+    const FlowStats& st = validator.getStats();
+    cout << st.packets << " packets, " << st.flows << " flows, " << st.alerts << " alerts, "
+         << validator.flows().memoryBytes() / validator.flows().capacity() << " bytes per flow slot" << endl;
+    cout << endl;
+}
+
+// === STREAM MODE ===
+// "--stream <file>" (or "-" / nothing for stdin) runs the validator as a
+// filter: the input is a sequence of packet events "<flow> <label>", tokens
+// separated by any whitespace, flows interleaved at will. Input is read in
+// 1 MB blocks and the tokens are string_views into the block, so nothing is
+// allocated per packet; only a pair cut by the end of a block is moved to the
+// front before the next read. Output is one line per flow in 64 KB batches:
+// "<flow> ALERT <label>" (or OVERFLOW) the moment a flow is trapped, then
+// "<flow> SUCCESS" / "<flow> WARN" for the others at the end of the input.
+// The batch also goes out whenever the input runs dry, so the tool keeps up
+// with a live pipe. Totals go to stderr. With "--metrics-file <file>" the
+// transition counters and step latencies (pda_metrics.h) are rewritten to it
+// every 5 seconds and at the end.
+class VerdictOut {
+public:
+    ~VerdictOut() { flush(); }
+
+    void line(string_view flow, const char* verdict, string_view label = {}) {
+        put(flow);
+        put(" ");
+        put(verdict);
+        if (!label.empty()) {
+            put(" ");
+            put(label);
+        }
+        put("\n");
+    }
+
+    void flush() {
+        if (len) fwrite(buf, 1, len, stdout);
+        len = 0;
+        fflush(stdout);
+    }
+
+private:
+    char buf[1 << 16];
+    size_t len = 0;
+
+    void put(string_view s) {
+        if (len + s.size() > sizeof(buf)) flush();
+        memcpy(buf + len, s.data(), s.size());   // tokens are shorter than a block
+        len += s.size();
+    }
+};
+
+// The flow id is the flow key: up to 36 bytes are stored as they are in the
+// key's address and port fields (proto = length). A longer id keeps its first
+// 28 bytes plus a 64-bit hash of the whole id (proto = 0xFF), and is kept
+// once, when its flow is first seen, to print its verdict.
+const size_t STREAM_ID_INLINE = 36;
+const uint8_t STREAM_ID_HASHED = 0xFF;
+
+FlowKey streamKey(string_view id, uint64_t& longHash) {
+    FlowKey k{};
+    char* raw = reinterpret_cast<char*>(&k);
+    if (id.size() <= STREAM_ID_INLINE) {
+        memcpy(raw, id.data(), id.size());
+        k.proto = uint8_t(id.size());
+    } else {
+        longHash = hash<string_view>{}(id);
+        memcpy(raw, id.data(), 28);
+        memcpy(raw + 28, &longHash, 8);
+        k.proto = STREAM_ID_HASHED;
+    }
+    return k;
+}
+
+// Whatever the input holds right now, up to n bytes; 0 at end of input.
+size_t readBlock(FILE* in, char* p, size_t n) {
+#if defined(_WIN32)
+    return fread(p, 1, n, in);
+#else
+    while (true) {
+        ssize_t got = ::read(fileno(in), p, n);
+        if (got >= 0) return size_t(got);
+        if (errno != EINTR) return 0;
+    }
+#endif
+}
+
+int runStream(const string& path, const string& metricsPath) {
+    FILE* in = path == "-" ? stdin : fopen(path.c_str(), "rb");
+    if (!in) {
+        cerr << "cannot open " << path << endl;
+        return 1;
+    }
+
+    const size_t BLOCK = 1 << 20;
+    vector<char> buf(BLOCK);
+    FlowValidator validator(protocol, 1 << 16, &signatures);
+    unordered_map<uint64_t, string> longIds;
+    VerdictOut out;
+    MetricsRegistry metrics(protocol);
+    MetricsExporter exporter(metrics);
+    string err;
+    if (!metricsPath.empty()) {
+        validator.setMetrics(metrics.add());
+        if (!exporter.start(metricsPath, 5, 0, err)) {
+            cerr << err << endl;
+            return 1;
+        }
+    }
+    auto idOf = [&](const FlowKey& k) {
+        if (k.proto != STREAM_ID_HASHED) return string_view(reinterpret_cast<const char*>(&k), k.proto);
+        uint64_t h;
+        memcpy(&h, reinterpret_cast<const char*>(&k) + 28, 8);
+        return string_view(longIds[h]);
+    };
+    auto isSpace = [](char c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; };
+
+    auto start = chrono::steady_clock::now();
+    size_t kept = 0;   // bytes of an unfinished pair carried over from the last block
+    uint64_t bytes = 0, dangling = 0;
+    bool eof = false;
+    while (!eof) {
+        size_t got = readBlock(in, buf.data() + kept, BLOCK - kept);
+        eof = got == 0;
+        bytes += got;
+        const char* p = buf.data();
+        size_t end = kept + got, pos = 0, done = 0;
+
+        // A token ends at whitespace; one that runs into the end of the block
+        // is only complete at the end of the input.
+        auto token = [&](string_view& tok) {
+            while (pos < end && isSpace(p[pos])) pos++;
+            size_t from = pos;
+            while (pos < end && !isSpace(p[pos])) pos++;
+            tok = string_view(p + from, pos - from);
+            return !tok.empty() && (pos < end || eof);
+        };
+        string_view id, label;
+        while (true) {
+            if (!token(id)) break;
+            if (!token(label)) {
+                if (eof) dangling++;
+                break;
+            }
+            done = pos;
+
+            uint64_t longHash = 0;
+            FlowKey key = streamKey(id, longHash);
+            if (longHash) longIds.try_emplace(longHash, id);
+            Symbol sym = classifyPacket(label);
+            const uint8_t* payload = sym == SYM_DATA ? reinterpret_cast<const uint8_t*>(label.data()) : nullptr;
+            uint32_t h = hashFlowKey(key);
+            if (validator.onPacket(key, h, sym, payload, payload ? label.size() : 0)) {
+                const FlowSlot* s = validator.flows().find(key, h);
+                out.line(id, verdictName(protocol.verdict(s->pda)), label);
+            }
+        }
+
+        kept = end - done;
+        if (kept == BLOCK) {
+            cerr << "token longer than " << BLOCK << " bytes" << endl;
+            return 1;
+        }
+        memmove(buf.data(), p + done, kept);
+        if (got < BLOCK - kept) out.flush();   // input ran dry: do not sit on verdicts
+    }
+    if (in != stdin) fclose(in);
+
+    validator.finish([&](const FlowSlot& s, Verdict v) {
+        if (v == VERDICT_SUCCESS || v == VERDICT_WARN) out.line(idOf(s.key), verdictName(v));
+    });
+    out.flush();
+    exporter.stop();
+    if (!exporter.error().empty()) cerr << "Metrics file: " << exporter.error() << endl;
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    const FlowStats& st = validator.getStats();
+    cerr << "Stream: " << st.packets << " packets, " << st.flows << " flows, " << st.alerts << " alerts ("
+         << st.signatures << " by signature), " << st.verdicts[VERDICT_SUCCESS] << " SUCCESS, "
+         << st.verdicts[VERDICT_WARN] << " WARN in " << fixed << setprecision(2) << secs << " s ("
+         << (secs > 0 ? double(bytes) / secs / 1e6 : 0) << " MB/s)" << endl;
+    if (dangling) cerr << "warning: input ended in the middle of a packet event" << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    // Optional: --pda <file> runs another protocol definition without recompiling,
+    // --sigs <file> another signature list
+    string err;
+    if (!protocol.load(pdaPathFromArgs(argc, argv), err) || !signatures.load(sigPathFromArgs(argc, argv), err) ||
+        !connection.compile(TCP_RFC793_PDA, err)) {
+        cerr << err << endl;
+        return 1;
+    }
+    actionLog = protocol.ruleTexts({
+        {"handshake",    "PUSH 'SESSION_ID'"},
+        {"no_handshake", "VIOLATION: No Handshake"},
+        {"tunnel",       "VERIFY Stack (OK)"},
+        {"hijack",       "ERROR: Stack Empty!"},
+        {"close",        "POP 'SESSION_ID'"},
+        {"reset",        "RST: POP 'SESSION_ID'"},
+        {"nested_open",  "PUSH 'TUNNEL'"},
+        {"nested_close", "POP 'TUNNEL'"},
+        {"teardown",     "Teardown (OK)"},
+        {"after_close",  "INTRUSION: Data after Close"},
+        {"blocked",      "Blocked"},
+    });
+    string metricsPath;
+    for (int i = 1; i + 1 < argc; i++)
+        if (string(argv[i]) == "--metrics-file") metricsPath = argv[i + 1];
+    for (int i = 1; i < argc; i++)
+        if (string(argv[i]) == "--stream")
+            return runStream(i + 1 < argc && string(argv[i + 1]).rfind("--", 0) != 0 ? argv[i + 1] : "-", metricsPath);
+
     // SCENARIO 1: Web Browsing (Valid)
     vector<string> webFlow = {"SYN", "ACK", "HTTP_GET", "JPG_DATA", "FIN"};
     runPDA(webFlow, "1. Standard Web Browsing (Valid)");
@@ -134,5 +422,59 @@ int main() {
     vector<string> hijackFlow = {"SYN", "ACK", "SSH_KEY", "FIN", "ROOT_CMD"};
     runPDA(hijackFlow, "4. Session Hijack (Data after FIN)");
 
+    // SCENARIO 5: All of the above at once, packets interleaved on the wire
+    runInterleaved({webFlow, sshFlow, nmapFlow, hijackFlow},
+                   {"Web Browsing", "SSH Session", "Nmap FIN Scan", "Session Hijack"},
+                   "5. Interleaved Flows (One Pass, Flow Table)");
+
+    // SCENARIO 6: Path Traversal (Attack)
+    // A valid session whose payload carries an exploit, split over two packets
+    vector<string> traversalFlow = {"SYN", "ACK", "GET /../..", "/etc/passwd", "FIN"};
+    runPDA(traversalFlow, "6. Path Traversal (Signature Split Across Packets)");
+
+    // SCENARIOS 7-10: the RFC 793 automaton, driven by flags byte + direction
+    connectionLog = connection.ruleTexts({
+        {"reject",        "VIOLATION: Illegal Flags"},
+        {"handshake",     "PUSH 'SESSION_ID'"},
+        {"no_handshake",  "VIOLATION: No Handshake"},
+        {"syn_ack",       "Handshake (SYN+ACK)"},
+        {"simultaneous",  "Simultaneous Open"},
+        {"established",   "Handshake Complete"},
+        {"tunnel",        "VERIFY Stack (OK)"},
+        {"hijack",        "ERROR: Out of Sequence"},
+        {"active_close",  "Initiator Closes"},
+        {"passive_close", "Responder Closes"},
+        {"half_close",    "Half-Closed (OK)"},
+        {"close",         "Both Sides Closed"},
+        {"last_ack",      "POP 'SESSION_ID'"},
+        {"reset",         "RST: POP 'SESSION_ID'"},
+        {"teardown",      "Teardown (OK)"},
+        {"after_close",   "INTRUSION: Data after Close"},
+        {"blocked",       "Blocked"},
+    });
+    runSegments({ {false, TCP_SYN, ""}, {true, TCP_SYN | TCP_ACK, ""}, {false, TCP_ACK, ""},
+                  {false, TCP_PSH | TCP_ACK, "GET /"}, {true, TCP_PSH | TCP_ACK, "200 OK"},
+                  {true, TCP_FIN | TCP_ACK, ""}, {false, TCP_FIN | TCP_ACK, ""}, {true, TCP_ACK, ""} },
+                "7. Full Connection, Passive Close (RFC 793)");
+    runSegments({ {false, TCP_SYN, ""}, {true, TCP_SYN, ""}, {false, TCP_SYN | TCP_ACK, ""},
+                  {true, TCP_SYN | TCP_ACK, ""}, {false, TCP_ACK, ""}, {true, TCP_RST, ""} },
+                "8. Simultaneous Open, then Reset (RFC 793)");
+    // Attacker probes with FIN+PSH+URG: no TCP stack sends that without ACK
+    runSegments({ {false, TCP_FIN | TCP_PSH | TCP_URG, ""} }, "9. Nmap XMAS Scan (Illegal Flags)");
+    // Attacker rides data on a retransmitted FIN once the connection is closed
+    runSegments({ {false, TCP_SYN, ""}, {true, TCP_SYN | TCP_ACK, ""}, {false, TCP_ACK, ""},
+                  {false, TCP_FIN | TCP_ACK, ""}, {true, TCP_FIN | TCP_ACK, ""}, {false, TCP_ACK, ""},
+                  {false, TCP_FIN | TCP_PSH | TCP_ACK, "rm -rf /"} },
+                "10. Data on a FIN in TIME_WAIT (RFC 793)");
+
+    // SCENARIO 11: Tunnels inside the session (VPN over TLS over ...): each SYN
+    // pushes a TUNNEL token, repeated tokens share one run of the stack
+    runPDA({"SYN", "ACK", "SYN", "SYN", "VPN_DATA", "FIN", "FIN", "FIN"}, "11. Nested Tunnels (Run-Length Stack)");
+
+    // SCENARIO 12: Attacker nests tunnels until the inline stack cannot hold them
+    vector<string> floodFlow = {"SYN", "ACK"};
+    floodFlow.insert(floodFlow.end(), 800, "SYN");
+    runPDA(floodFlow, "12. Tunnel Flood (Stack Overflow)");
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,524 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stack>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include "../PDACore/pda_parallel.h"
+#include "../PDACore/pda_simd.h"
+
+using namespace std;
+
+// === BENCHMARK: STRING PDA vs SYMBOL PDA vs TABLE PDA ===
+// Micro (single steps, whole demo flows, lockstep batches, payload scans) and
+// macro (interleaved multi-flow streams, sharded workers) benchmarks. Every
+// result reports ns/packet, packets/s and p50/p99 latency; latencies are per
+// packet within timed samples of a few hundred packets, since one step is far
+// below the clock's resolution.
+// Usage: Benchmark [rounds] [flows] [max workers] [--json out.ndjson] [--baseline old.ndjson]
+//   --json      also write every result as one JSON object per line
+//   --baseline  compare against an earlier --json file; exit code 3 when a
+//               result got more than REGRESSION_PCT slower
+// Build with optimizations, e.g. g++ -O2 -pthread Benchmark_TCP3WayHandshake_PDA.cpp
+
+// === RESULTS ===
+struct BenchResult {
+    string name;
+    double nsPerPacket = 0;
+    double pps = 0;
+    double p50 = 0, p99 = 0;    // ns per packet within one sample, 0 = not sampled
+    double bytesPerFlow = 0;    // flow-table benchmarks only
+    string note;                // free text for the console (checksums, hits, ...)
+};
+
+vector<BenchResult> results;
+const double REGRESSION_PCT = 10;
+
+// Per-sample timings of one benchmark, each normalised to ns per packet
+struct Samples {
+    vector<double> nsPerPacket;
+    double totalNs = 0;
+    double packets = 0;
+
+    void add(double ns, size_t n) {
+        totalNs += ns;
+        packets += double(n);
+        if (n) nsPerPacket.push_back(ns / double(n));
+    }
+
+    double percentile(double p) {
+        if (nsPerPacket.empty()) return 0;
+        size_t k = min(nsPerPacket.size() - 1, size_t(p / 100.0 * double(nsPerPacket.size())));
+        nth_element(nsPerPacket.begin(), nsPerPacket.begin() + long(k), nsPerPacket.end());
+        return nsPerPacket[k];
+    }
+};
+
+double elapsedNs(chrono::steady_clock::time_point t0) {
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+}
+
+void record(BenchResult r) {
+    cout << left << setw(30) << r.name << " | " << right << setw(8) << fixed << setprecision(2)
+         << r.nsPerPacket << " ns/packet | " << setw(7) << r.pps / 1e6 << " Mpps | ";
+    if (r.p99 > 0) cout << "p50 " << setw(7) << r.p50 << " p99 " << setw(8) << r.p99;
+    else cout << setw(24) << "-";
+    if (!r.note.empty()) cout << "   (" << r.note << ")";
+    cout << endl;
+    results.push_back(r);
+}
+
+BenchResult fromSamples(const string& name, Samples& s, const string& note = "") {
+    BenchResult r;
+    r.name = name;
+    r.nsPerPacket = s.packets ? s.totalNs / s.packets : 0;
+    r.pps = s.totalNs ? s.packets / s.totalNs * 1e9 : 0;
+    r.p50 = s.percentile(50);
+    r.p99 = s.percentile(99);
+    r.note = note;
+    return r;
+}
+
+string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// One line per result, plus a first line describing the build
+bool writeJson(const string& path) {
+    ofstream out(path);
+    if (!out) return false;
+    out << "{\"build\": \"" << jsonEscape(__VERSION__) << "\", \"simd\": \"" << simdPathName(detectSimdPath())
+        << "\", \"threads\": " << thread::hardware_concurrency() << "}" << endl;
+    out << setprecision(6);
+    for (const BenchResult& r : results)
+        out << "{\"bench\": \"" << jsonEscape(r.name) << "\", \"ns_per_packet\": " << r.nsPerPacket
+            << ", \"pps\": " << r.pps << ", \"p50_ns\": " << r.p50 << ", \"p99_ns\": " << r.p99
+            << ", \"bytes_per_flow\": " << r.bytesPerFlow << "}" << endl;
+    return true;
+}
+
+// Reads "bench" and "ns_per_packet" back from a --json file (only what
+// writeJson produces, no general JSON parser). Returns how many results
+// regressed by more than REGRESSION_PCT.
+int compareBaseline(const string& path) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "cannot open baseline " << path << endl;
+        return 0;
+    }
+    int regressions = 0;
+    string line;
+    cout << "-----------------------------------------------------------" << endl;
+    cout << "Against " << path << " (regression = more than " << int(REGRESSION_PCT) << "% slower):" << endl;
+    while (getline(in, line)) {
+        size_t n = line.find("\"bench\": \""), v = line.find("\"ns_per_packet\": ");
+        if (n == string::npos || v == string::npos) continue;
+        n += 10;
+        string name = line.substr(n, line.find('"', n) - n);
+        double old = atof(line.c_str() + v + 17);
+        for (const BenchResult& r : results) {
+            if (r.name != name || old <= 0) continue;
+            double change = (r.nsPerPacket - old) / old * 100;
+            bool slower = change > REGRESSION_PCT;
+            regressions += slower;
+            cout << left << setw(30) << name << " | " << right << setw(8) << fixed << setprecision(2) << old
+                 << " -> " << setw(8) << r.nsPerPacket << " ns/packet  " << showpos << setprecision(1) << change
+                 << noshowpos << "%" << (slower ? "   <-- REGRESSION" : "") << endl;
+        }
+    }
+    return regressions;
+}
+
+// === ENGINES ===
+// The original string-compare engine, kept here as the "before" baseline.
+int legacyRunPDA(const vector<string>& packets) {
+    stack<string> memoryStack;
+    memoryStack.push("Z0");
+    int state = 0;
+    for (const string& packet : packets) {
+        if (state == 0) {
+            if (packet == "SYN") { memoryStack.push("SESSION_ID"); state = 1; }
+            else state = 3;
+        } else if (state == 1) {
+            if (packet == "FIN") {
+                if (!memoryStack.empty() && memoryStack.top() == "SESSION_ID") { memoryStack.pop(); state = 2; }
+            } else if (memoryStack.empty() || memoryStack.top() != "SESSION_ID") {
+                state = 3;
+            }
+        } else {
+            state = 3;
+        }
+        if (state == 3) break;
+    }
+    return state;
+}
+
+// Hand-written switch on symbol IDs, the engine before it became table driven.
+int switchRunPDA(const vector<Symbol>& symbols) {
+    uint8_t state = 0, depth = 1, stack[4] = { STK_Z0 };
+    for (Symbol sym : symbols) {
+        if (state == Q0_LISTEN) {
+            if (sym == SYM_SYN) { stack[depth++] = STK_SESSION; state = Q1_ACTIVE; }
+            else state = Q_TRAP;
+        } else if (state == Q1_ACTIVE) {
+            if (stack[depth - 1] != STK_SESSION) state = Q_TRAP;
+            else if (sym == SYM_FIN) { depth--; state = Q2_CLOSED; }
+        } else {
+            state = Q_TRAP;
+        }
+        if (state == Q_TRAP) break;
+    }
+    return state;
+}
+
+PdaTable protocol;
+
+// Labels classified per packet (what the front ends do).
+int tableRunPDA(const vector<string>& packets) {
+    PdaConfig pda;
+    protocol.reset(pda);
+    for (const string& packet : packets) {
+        protocol.step(pda, classifyPacket(packet));
+        if (protocol.isTrap(pda.state)) break;
+    }
+    return pda.state;
+}
+
+// Labels classified ahead of time (what a capture pipeline does).
+int idRunPDA(const vector<Symbol>& symbols) {
+    PdaConfig pda;
+    protocol.reset(pda);
+    protocol.run(pda, symbols.data(), symbols.size());
+    return pda.state;
+}
+
+// Whole-flow validation: every demo flow from the start state, timed in
+// samples of 16 rounds.
+template <typename Flow, typename Fn>
+void report(const string& name, const vector<Flow>& flows, Fn run, long rounds) {
+    const long CHUNK = 16;
+    size_t packets = 0;
+    for (const Flow& f : flows) packets += f.size();
+
+    unsigned sink = 0;
+    Samples s;
+    for (long r = 0; r < rounds; r += CHUNK) {
+        auto t0 = chrono::steady_clock::now();
+        for (long k = 0; k < CHUNK; k++)
+            for (const Flow& f : flows) sink += run(f);
+        s.add(elapsedNs(t0), packets * CHUNK);
+    }
+    record(fromSamples(name, s, "checksum " + to_string(sink)));
+}
+
+// Per-packet step cost: one long-lived session stepping through data packets
+// (q1 -> q1, stack untouched), the engine's innermost operation on its own.
+void benchStep(long steps) {
+    const long CHUNK = 256;
+    PdaConfig pda;
+    protocol.reset(pda);
+    protocol.step(pda, SYM_SYN);
+    protocol.step(pda, SYM_ACK);
+    const Symbol inputs[4] = { SYM_DATA, SYM_ACK, SYM_DATA, SYM_DATA };
+
+    unsigned sink = 0;
+    Samples s;
+    for (long i = 0; i < steps; i += CHUNK) {
+        auto t0 = chrono::steady_clock::now();
+        for (long k = 0; k < CHUNK; k++) sink += protocol.step(pda, inputs[k & 3]).next;
+        s.add(elapsedNs(t0), CHUNK);
+    }
+    record(fromSamples("step: one packet, q1", s, "checksum " + to_string(sink)));
+}
+
+// Interleaved multi-flow stream: every flow is a 5-packet web session and the
+// stream deals packet n of every flow (in shuffled flow order) before packet n+1,
+// so consecutive packets almost never share a flow or a cache line.
+void benchInterleaved(size_t flowCount, bool batched) {
+    const Symbol pattern[] = { SYM_SYN, SYM_ACK, SYM_DATA, SYM_DATA, SYM_FIN };
+    const size_t perFlow = sizeof(pattern) / sizeof(pattern[0]);
+
+    vector<uint32_t> order(flowCount);
+    for (size_t i = 0; i < flowCount; i++) order[i] = uint32_t(i);
+    shuffle(order.begin(), order.end(), mt19937(42));
+
+    FlowValidator validator(protocol, flowCount);
+    const size_t BATCH = 256;
+    FlowKey keys[BATCH];
+    Symbol syms[BATCH];
+    Samples s;
+    for (size_t n = 0; n < perFlow; n++) {
+        for (size_t base = 0; base < flowCount; base += BATCH) {
+            size_t m = min(BATCH, flowCount - base);
+            auto t0 = chrono::steady_clock::now();
+            for (size_t i = 0; i < m; i++) {
+                uint32_t f = order[base + i];
+                keys[i] = FlowKey::ipv4(0x0A000000 + f, 0xC0A8010A, uint16_t(1024 + (f & 0x7FFF)), 443);
+                syms[i] = pattern[n];
+            }
+            if (batched) validator.onBatch(keys, syms, m);
+            else for (size_t i = 0; i < m; i++) validator.onPacket(keys[i], syms[i]);
+            s.add(elapsedNs(t0), m);
+        }
+    }
+
+    size_t success = 0;
+    validator.finish([&](const FlowSlot&, Verdict v) { success += (v == VERDICT_SUCCESS); });
+    const FlowTable& table = validator.flows();
+    string name = string(batched ? "flows+prefetch: " : "flows: ") + to_string(flowCount);
+    BenchResult r = fromSamples(name, s, to_string(success) + " closed");
+    r.bytesPerFlow = double(table.memoryBytes()) / double(table.size());
+    ostringstream mem;
+    mem << fixed << setprecision(1) << r.bytesPerFlow;
+    r.note += ", " + mem.str() + " bytes/flow";
+    record(r);
+}
+
+// SYN flood on the RFC 793 automaton: every packet opens a new half-open flow
+// from a spoofed source, stamped at 1 Mpps, and every 16th packet belongs to a
+// real client going through a whole session (handshake, data-less close). Without defences the
+// table grows with every packet; timeouts hold it to ~100 ms of flood; the
+// half-open filter keeps the flood out of the table altogether (fixed size).
+enum FloodDefence { FLOOD_NONE, FLOOD_TIMEOUTS, FLOOD_FILTER };
+
+void benchFlood(size_t packets, FloodDefence defence) {
+    static const char* const NAMES[] = { "SYN flood: ", "SYN flood+timeouts: ", "SYN flood+half-open: " };
+    const uint64_t INTERVAL_NS = 1000;
+    const size_t HALF_OPEN = 1 << 18;
+    PdaTable rfc;
+    string err;
+    rfc.load("", err, TCP_RFC793_PDA);
+    FlowValidator validator(rfc, 1024);
+    FlowTimeouts timeouts;
+    if (defence != FLOOD_NONE) timeouts.handshakeNanos = timeouts.idleNanos = timeouts.lingerNanos = 100000000;
+    validator.setTimeouts(timeouts);
+    if (defence == FLOOD_FILTER) validator.setHalfOpenFilter(HALF_OPEN);
+
+    auto key = [](uint64_t f) {
+        return FlowKey::ipv4(uint32_t(f * 2654435761u), 0xC0A8010A, uint16_t(1024 + (f & 0x7FFF)), 443);
+    };
+    const uint8_t FLAGS[] = { TCP_SYN, TCP_SYN | TCP_ACK, TCP_ACK, TCP_FIN | TCP_ACK, TCP_FIN | TCP_ACK, TCP_ACK };
+    const size_t CHUNK = 256;
+    Samples s;
+    for (size_t base = 0; base < packets; base += CHUNK) {
+        size_t m = min(CHUNK, packets - base);
+        auto t0 = chrono::steady_clock::now();
+        for (size_t i = base; i < base + m; i++) {
+            if (defence != FLOOD_NONE) validator.advance(i * INTERVAL_NS);
+            // Every 16th packet is the next segment of the current real client
+            bool client = i % 16 == 15;
+            size_t j = i / 16;
+            FlowKey fk = client ? key(0x80000000u + j / 6) : key(i);
+            bool fromResponder = client && (j % 6 == 1 || j % 6 == 4);
+            bool reversed = fk.canonicalize();
+            validator.onSegment(fk, hashFlowKey(fk), reversed != fromResponder, client ? FLAGS[j % 6] : uint8_t(TCP_SYN));
+        }
+        s.add(elapsedNs(t0), m);
+    }
+
+    validator.finish([](const FlowSlot&, Verdict) {});
+    const FlowStats& st = validator.getStats();
+    size_t bytes = validator.flows().memoryBytes() + validator.timers().memoryBytes() +
+                   validator.halfOpenFilter().memoryBytes();
+    ostringstream note;
+    note << "peak " << st.peakFlows << " in table, " << st.verdicts[VERDICT_SUCCESS] << " closed, "
+         << fixed << setprecision(1) << double(bytes) / (1 << 20) << " MiB";
+    if (defence == FLOOD_FILTER) {
+        // False positives: flows never seen that the filter claims to hold
+        size_t hits = 0, probes = 1 << 22;
+        for (size_t i = 0; i < probes; i++) hits += validator.halfOpenFilter().contains(hashFlowKey64(key(0x40000000u + i)));
+        note << ", fp " << setprecision(2) << scientific << double(hits) / double(probes)
+             << " at " << validator.halfOpenFilter().size() << " held";
+    }
+    record(fromSamples(NAMES[defence] + to_string(packets), s, note.str()));
+}
+
+// Same interleaved stream through the sharded validator: the calling thread
+// dispatches, `workers` threads validate. Returns packets per second.
+double benchSharded(size_t flowCount, unsigned workers, double baseline) {
+    const Symbol pattern[] = { SYM_SYN, SYM_ACK, SYM_DATA, SYM_DATA, SYM_FIN };
+    const size_t perFlow = sizeof(pattern) / sizeof(pattern[0]);
+
+    vector<uint32_t> order(flowCount);
+    for (size_t i = 0; i < flowCount; i++) order[i] = uint32_t(i);
+    shuffle(order.begin(), order.end(), mt19937(42));
+
+    auto t0 = chrono::steady_clock::now();
+    FlowStats st;
+    {
+        ShardedValidator sharded(protocol, workers, flowCount);
+        for (size_t n = 0; n < perFlow; n++)
+            for (uint32_t f : order)
+                sharded.dispatch(FlowKey::ipv4(0x0A000000 + f, 0xC0A8010A, uint16_t(1024 + (f & 0x7FFF)), 443), pattern[n]);
+        st = sharded.finish();
+    }
+    auto t1 = chrono::steady_clock::now();
+
+    // Packets cross threads through the rings, so only throughput is measured
+    BenchResult r;
+    r.name = "sharded: " + to_string(workers) + " worker" + (workers > 1 ? "s" : "");
+    r.nsPerPacket = chrono::duration<double, nano>(t1 - t0).count() / double(st.packets);
+    r.pps = 1e9 / r.nsPerPacket;
+    ostringstream note;
+    note << "speedup x" << fixed << setprecision(2) << (baseline > 0 ? r.pps / baseline : 1.0) << ", "
+         << st.verdicts[VERDICT_SUCCESS] << " closed";
+    r.note = note.str();
+    record(r);
+    return r.pps;
+}
+
+// Lockstep re-validation: `width` stored flows advance one packet each per
+// step, the shape pdaStepConfigs is built for. Flows mix a clean session, a
+// hijack and a missing handshake so the lanes do not all hit the same cell.
+void benchLockstep(size_t width, SimdPath path, long rounds) {
+    const Symbol patterns[3][5] = {
+        { SYM_SYN, SYM_ACK, SYM_DATA, SYM_DATA, SYM_FIN },
+        { SYM_SYN, SYM_ACK, SYM_DATA, SYM_FIN, SYM_DATA },
+        { SYM_FIN, SYM_ACK, SYM_DATA, SYM_DATA, SYM_FIN },
+    };
+    vector<PdaConfig> configs(width);
+    vector<Symbol> column[5];
+    for (size_t n = 0; n < 5; n++)
+        for (size_t i = 0; i < width; i++) column[n].push_back(patterns[i % 3][n]);
+
+    unsigned sink = 0;
+    Samples s;
+    for (long r = 0; r < rounds; r++) {
+        auto t0 = chrono::steady_clock::now();
+        for (PdaConfig& c : configs) protocol.reset(c);
+        for (size_t n = 0; n < 5; n++) pdaStepConfigs(protocol, configs.data(), column[n].data(), width, path);
+        s.add(elapsedNs(t0), width * 5);
+        for (const PdaConfig& c : configs) sink += c.state;
+    }
+    string name = string("lockstep ") + simdPathName(path) + ": " + to_string(width) + " flows";
+    record(fromSamples(name, s, "checksum " + to_string(sink)));
+}
+
+// Payload inspection: `packets` HTTP-like payloads, `hostilePct` percent of
+// them carrying an attack string, scanned by the DFA alone and behind the
+// literal prefilter. `extraSigs` synthetic signatures are added to the
+// built-in ones to see how both scale with a large rule set.
+void benchSignatures(size_t extraSigs, int hostilePct) {
+    mt19937 rng(7);
+    string def = DEFAULT_SIGNATURES;
+    for (size_t i = 0; i < extraSigs; i++) {
+        string word;
+        for (int j = 0; j < 6; j++) word += char('a' + rng() % 26);
+        def += "sig gen" + to_string(i) + ": " + word + "[0-9]{2}(=|:)" + to_string(i) + "\n";
+    }
+    SignatureSet sigs;
+    string err;
+    if (!sigs.compile(def, err)) {
+        cerr << err << endl;
+        return;
+    }
+
+    const char* words[] = { "GET", "/index.html", "HTTP/1.1", "Host:", "example.org", "Accept:", "text/html",
+                            "Cookie:", "session=9f8e7d", "User-Agent:", "Mozilla/5.0", "\r\n", "gzip", "keep-alive" };
+    const char* attacks[] = { "GET /../../etc/passwd", "/bin/bash -i", "1 UNION ALL SELECT pw", "eval(base64_decode(" };
+    vector<string> payloads(4096);
+    size_t bytes = 0;
+    for (size_t i = 0; i < payloads.size(); i++) {
+        string& p = payloads[i];
+        size_t len = 512 + rng() % 949;
+        while (p.size() < len) p += string(words[rng() % 14]) + " ";
+        if (int(rng() % 100) < hostilePct) p.insert(rng() % p.size(), attacks[rng() % 4]);
+        bytes += p.size();
+    }
+
+    for (int filtered = 0; filtered < 2; filtered++) {
+        const int rounds = 20;
+        size_t hits = 0;
+        Samples s;
+        for (int r = 0; r < rounds; r++)
+            for (const string& p : payloads) {
+                uint16_t state = 0;
+                const uint8_t* data = reinterpret_cast<const uint8_t*>(p.data());
+                auto t0 = chrono::steady_clock::now();
+                hits += (filtered ? sigs.inspect(state, data, p.size()) : sigs.scan(state, data, p.size())) >= 0;
+                s.add(elapsedNs(t0), 1);
+            }
+        string name = string(filtered ? "prefilter+DFA" : "DFA only") + ": " + to_string(sigs.names.size()) + " sigs, "
+                    + to_string(hostilePct) + "%";
+        ostringstream note;
+        note << fixed << setprecision(2) << double(bytes) * rounds / s.totalNs << " GB/s, " << hits / rounds << " hits";
+        record(fromSamples(name, s, note.str()));
+    }
+}
+
+int main(int argc, char** argv) {
+    vector<string> args;
+    string jsonPath, baselinePath;
+    for (int i = 1; i < argc; i++) {
+        string a = argv[i];
+        if (a == "--json" && i + 1 < argc) jsonPath = argv[++i];
+        else if (a == "--baseline" && i + 1 < argc) baselinePath = argv[++i];
+        else args.push_back(a);
+    }
+    long rounds = (args.size() > 0) ? atol(args[0].c_str()) : 2000000;
+    size_t flowCount = (args.size() > 1) ? size_t(atol(args[1].c_str())) : 1000000;
+    unsigned maxWorkers = (args.size() > 2) ? unsigned(atoi(args[2].c_str())) : max(1u, thread::hardware_concurrency());
+    string err;
+    if (!protocol.load("", err)) {
+        cerr << err << endl;
+        return 1;
+    }
+
+    vector<vector<string>> flows = {
+        {"SYN", "ACK", "HTTP_GET", "JPG_DATA", "FIN"},
+        {"SYN", "ACK", "SSH_KEY", "ENCRYPTED_CMD", "FIN"},
+        {"FIN"},
+        {"SYN", "ACK", "SSH_KEY", "FIN", "ROOT_CMD"},
+    };
+    vector<vector<Symbol>> symbolFlows;
+    for (const auto& f : flows) {
+        vector<Symbol> ids;
+        for (const string& pkt : f) ids.push_back(classifyPacket(pkt));
+        symbolFlows.push_back(ids);
+    }
+
+    cout << "Rounds: " << rounds << " x 4 scenarios" << endl;
+    cout << "-----------------------------------------------------------" << endl;
+    benchStep(rounds * 8);
+    report("before: string + stack<str>", flows, legacyRunPDA, rounds);
+    report("switch: pre-classified IDs", symbolFlows, switchRunPDA, rounds);
+    report("table:  classify + step", flows, tableRunPDA, rounds);
+    report("table:  pre-classified IDs", symbolFlows, idRunPDA, rounds);
+    // Batch stepping: scalar lookups vs one gather per 8 flows
+    cout << "-----------------------------------------------------------" << endl;
+    cout << "SIMD path: " << simdPathName(detectSimdPath()) << endl;
+    for (size_t width : { 16, 64 }) {
+        benchLockstep(width, SIMD_SCALAR, rounds / 16);
+        if (detectSimdPath() == SIMD_AVX2) benchLockstep(width, SIMD_AVX2, rounds / 16);
+    }
+    // Payload signatures: clean vs hostile traffic, small vs large rule sets
+    cout << "-----------------------------------------------------------" << endl;
+    for (size_t extra : { size_t(0), size_t(1000) })
+        for (int hostile : { 0, 1, 20 }) benchSignatures(extra, hostile);
+    cout << "-----------------------------------------------------------" << endl;
+    benchInterleaved(1000, false);
+    benchInterleaved(flowCount, false);
+    benchInterleaved(flowCount, true);
+    for (FloodDefence d : { FLOOD_NONE, FLOOD_TIMEOUTS, FLOOD_FILTER }) benchFlood(flowCount * 4, d);
+
+    // Scaling: 1, 2, 4, ... workers (plus the dispatcher thread)
+    cout << "-----------------------------------------------------------" << endl;
+    cout << "Hardware threads: " << thread::hardware_concurrency() << endl;
+    double base = benchSharded(flowCount, 1, 0);
+    for (unsigned w = 2; w <= maxWorkers; w *= 2) benchSharded(flowCount, w, base);
+
+    if (!jsonPath.empty() && !writeJson(jsonPath)) cerr << "cannot write " << jsonPath << endl;
+    if (!baselinePath.empty() && compareBaseline(baselinePath) > 0) return 3;
+    return 0;
+}
@@ -0,0 +1,290 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+#include "../PDACore/pda_alerts.h"
+#include "../PDACore/pda_corpus.h"
+#include "../PDACore/pda_parallel.h"
+#include "../PDACore/pda_trace.h"
+
+using namespace std;
+
+// === CAPTURE VALIDATOR ===
+// Runs every TCP conversation of a .pcap / .pcapng file (or a TrafficGenerator
+// corpus) through the PDA.
+// Usage: CaptureValidator <capture> [--pda <file>] [--sigs <file>] [--alerts <n>] [--threads <n>] [--decode-only]
+//                         [--idle-timeout <s>] [--handshake-timeout <s>] [--linger <s>] [--no-timeouts]
+//                         [--half-open <n>] [--trace <file>]
+//                         [--alert-log <file>] [--alert-format ndjson|binary] [--alert-rotate <MB>] [--alert-block]
+//                         [--metrics-file <file>] [--metrics-interval <s>] [--metrics-port <port>]
+//                         [--spans <prefix>] [--span-min <ns>] [--span-buffer <n>]
+// With --threads the reader only dispatches; n worker threads own the flow table shards.
+// Flows are evicted on capture time: half-open after --handshake-timeout (30 s),
+// quiet after --idle-timeout (300 s), finished or trapped after --linger (60 s);
+// 0 never evicts that class.
+// Flows still in their handshake wait in a half-open filter sized for --half-open
+// flows (262144, 0 = off) and only take a table slot once past it.
+// Payloads of in-session packets are matched against the signature DFA on the way.
+// --trace writes every step of every flow to a .pdatrace file for the visualizers
+// (single-threaded, half-open filter off, so every packet steps a table slot).
+// --alert-log streams every violation, as it happens, to a log written by its own
+// thread (pda_alerts.h), rotated every --alert-rotate MB (64); with --alert-block a
+// full queue stalls validation instead of dropping alerts.
+// --metrics-file / --metrics-port publish per-transition counters, verdicts and step
+// latency quantiles in Prometheus text format (pda_metrics.h): the file is rewritten
+// every --metrics-interval seconds (5), the port answers on 127.0.0.1.
+// --spans records rdtsc-stamped stage spans (decode, lookup, classify, transition,
+// signature, emit) per thread (pda_spans.h) and writes <prefix>.json (Chrome trace
+// events) and <prefix>.folded (flamegraph stacks); --span-min keeps only packets
+// slower than that, --span-buffer spans per thread (262144, newest kept).
+// Without --pda the full RFC 793 connection automaton runs, fed from the flags byte.
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <capture.pcap|capture.pcapng|corpus.pdacorpus> [--pda <file>] [--sigs <file>] [--alerts <n>] [--threads <n>] [--decode-only]"
+             << " [--idle-timeout <s>] [--handshake-timeout <s>] [--linger <s>] (0 = never) [--no-timeouts] [--half-open <n>] [--trace <file>]"
+             << " [--alert-log <file>] [--alert-format ndjson|binary] [--alert-rotate <MB>] [--alert-block]"
+             << " [--metrics-file <file>] [--metrics-interval <s>] [--metrics-port <port>]"
+             << " [--spans <prefix>] [--span-min <ns>] [--span-buffer <n>]" << endl;
+        return 1;
+    }
+    string path = argv[1];
+    size_t maxAlerts = 20;
+    unsigned threads = 0;
+    bool decodeOnly = false;
+    size_t halfOpen = 1 << 18;
+    string tracePath;
+    AlertSinkOptions alertLog;
+    string metricsPath;
+    double metricsInterval = 5;
+    int metricsPort = 0;
+    string spansPrefix;
+    uint64_t spanMin = 0;
+    size_t spanBuffer = 1 << 18;
+    FlowTimeouts timeouts;
+    timeouts.handshakeNanos = 30000000000ULL;
+    timeouts.idleNanos = 300000000000ULL;
+    timeouts.lingerNanos = 60000000000ULL;
+    auto seconds = [](const char* s) { return uint64_t(atof(s) * 1e9); };
+    for (int i = 2; i < argc; i++) {
+        string a = argv[i];
+        if (a == "--alerts" && i + 1 < argc) maxAlerts = size_t(atol(argv[++i]));
+        else if (a == "--threads" && i + 1 < argc) threads = unsigned(atoi(argv[++i]));
+        else if (a == "--decode-only") decodeOnly = true;
+        else if (a == "--idle-timeout" && i + 1 < argc) timeouts.idleNanos = seconds(argv[++i]);
+        else if (a == "--handshake-timeout" && i + 1 < argc) timeouts.handshakeNanos = seconds(argv[++i]);
+        else if (a == "--linger" && i + 1 < argc) timeouts.lingerNanos = seconds(argv[++i]);
+        else if (a == "--no-timeouts") timeouts = FlowTimeouts();
+        else if (a == "--half-open" && i + 1 < argc) halfOpen = size_t(atol(argv[++i]));
+        else if (a == "--trace" && i + 1 < argc) tracePath = argv[++i];
+        else if (a == "--alert-log" && i + 1 < argc) alertLog.path = argv[++i];
+        else if (a == "--alert-format" && i + 1 < argc) alertLog.format = string(argv[++i]) == "binary" ? ALERT_BINARY : ALERT_NDJSON;
+        else if (a == "--alert-rotate" && i + 1 < argc) alertLog.rotateBytes = uint64_t(atof(argv[++i]) * (1 << 20));
+        else if (a == "--alert-block") alertLog.block = true;
+        else if (a == "--metrics-file" && i + 1 < argc) metricsPath = argv[++i];
+        else if (a == "--metrics-interval" && i + 1 < argc) metricsInterval = atof(argv[++i]);
+        else if (a == "--metrics-port" && i + 1 < argc) metricsPort = atoi(argv[++i]);
+        else if (a == "--spans" && i + 1 < argc) spansPrefix = argv[++i];
+        else if (a == "--span-min" && i + 1 < argc) spanMin = uint64_t(atoll(argv[++i]));
+        else if (a == "--span-buffer" && i + 1 < argc) spanBuffer = size_t(atol(argv[++i]));
+    }
+    if (!tracePath.empty()) {
+        threads = 0;
+        halfOpen = 0;
+    }
+
+    PdaTable protocol;
+    string err;
+    if (!protocol.load(pdaPathFromArgs(argc, argv), err, TCP_RFC793_PDA)) {
+        cerr << err << endl;
+        return 1;
+    }
+
+    SignatureSet signatures;
+    if (!signatures.load(sigPathFromArgs(argc, argv), err)) {
+        cerr << err << endl;
+        return 1;
+    }
+
+    MappedFile capture;
+    if (!capture.open(path, err)) {
+        cerr << err << endl;
+        return 1;
+    }
+
+    AlertSink alerts(protocol, &signatures);
+    if (!alertLog.path.empty() && !decodeOnly && !alerts.open(alertLog, err)) {
+        cerr << err << endl;
+        return 1;
+    }
+
+    MetricsRegistry metrics(protocol);
+    MetricsExporter exporter(metrics);
+    bool measured = (!metricsPath.empty() || metricsPort > 0) && !decodeOnly;
+    // Started once every validator has its block (the registry is not locked)
+    auto startMetrics = [&] {
+        if (measured && !exporter.start(metricsPath, metricsInterval, metricsPort, err)) {
+            cerr << err << endl;
+            exit(1);
+        }
+    };
+
+    // Decode spans: the reader's time from one packet handed over to the next
+    bool spanned = !spansPrefix.empty() && !decodeOnly;
+    unique_ptr<SpanTracer> tracer(spanned ? new SpanTracer(spanBuffer, spanMin) : nullptr);
+    SpanRing* readerSpans = nullptr;
+    uint64_t decodeFrom = 0;
+    size_t decodeMark = 0;
+    auto decoded = [&] {
+        if (!readerSpans) return;
+        readerSpans->top(SPAN_DECODE, decodeFrom, readTsc(), decodeMark);
+    };
+    auto nextDecode = [&] {
+        if (!readerSpans) return;
+        decodeMark = readerSpans->mark();
+        decodeFrom = readTsc();
+    };
+
+    CaptureStats cs;
+    uint64_t checksum = 0;
+    FlowStats st;
+    vector<pair<FlowKey, uint16_t>> alerted;   // flow + scan state (SCAN_HIT | signature)
+    TraceWriter trace(protocol);
+    auto keyHash = [](const FlowKey& k) { return size_t(hashFlowKey64(k)); };
+    unordered_map<FlowKey, uint32_t, decltype(keyHash)> traced(1024, keyHash);   // live flow -> trace flow
+    auto collect = [&](const FlowSlot& s, Verdict v) {
+        if ((v == VERDICT_ALERT || v == VERDICT_OVERFLOW) && alerted.size() < maxAlerts) alerted.push_back({ s.key, s.scan });
+        traced.erase(s.key);   // the 5-tuple may come back as a new flow
+    };
+
+    auto t0 = chrono::steady_clock::now();
+    bool ok;
+    if (decodeOnly) {
+        // Reader throughput on its own: decode every segment, touch nothing else
+        ok = readPacketFile(capture.data(), capture.size(), cs, err, [&](const PacketEvent& ev) {
+            checksum += ev.sym + ev.payloadLen;
+        });
+    } else if (threads > 0) {
+        ShardedValidator sharded(protocol, threads, 1 << 16, &signatures, timeouts, halfOpen);
+        if (alerts.isOpen())
+            sharded.setAlertHook([&](unsigned shard, const FlowSlot& s, const FlowAlert& a) { alerts.push(makeAlertRecord(s, a, shard)); });
+        if (measured) sharded.setMetrics(metrics);
+        startMetrics();
+        if (spanned) {
+            readerSpans = tracer->thread("reader");
+            sharded.setSpans(*tracer);
+        }
+        nextDecode();
+        ok = readPacketFile(capture.data(), capture.size(), cs, err, [&](const PacketEvent& ev) {
+            decoded();
+            sharded.dispatchSegment(ev.key, ev.reversed, ev.tcpFlags, ev.hasPayload, ev.payload, ev.payloadLen, ev.tsNanos);
+            nextDecode();
+        });
+        st = sharded.finish(collect);
+    } else {
+        FlowValidator validator(protocol, 1 << 16, &signatures);
+        validator.setTimeouts(timeouts);
+        validator.setHalfOpenFilter(halfOpen);
+        if (alerts.isOpen()) validator.setAlertHook([&](const FlowSlot& s, const FlowAlert& a) { alerts.push(makeAlertRecord(s, a)); });
+        if (measured) validator.setMetrics(metrics.add());
+        startMetrics();
+        if (spanned) {
+            readerSpans = tracer->thread("validator");
+            validator.setSpans(readerSpans);
+        }
+        if (!tracePath.empty())
+            validator.setStepHook([&](const FlowSlot& s, Symbol sym, const PdaTransition& t, bool blocked) {
+                auto it = traced.find(s.key);
+                if (it == traced.end()) it = traced.emplace(s.key, trace.addFlow(formatFlow(s.key))).first;
+                uint8_t flags = blocked ? TRACE_BLOCKED : 0;
+                if (!blocked && protocol.isTrap(s.pda.state)) flags |= (s.scan & SCAN_HIT) ? TRACE_ATTACK | TRACE_SIGNATURE : TRACE_ATTACK;
+                trace.step(it->second, sym, t, s.pda, flags, symbolName(sym));
+            });
+        bool timed = timeouts.enabled();
+        nextDecode();
+        ok = readPacketFile(capture.data(), capture.size(), cs, err, [&](const PacketEvent& ev) {
+            decoded();
+            if (timed) validator.advance(ev.tsNanos, collect);
+            validator.onSegment(ev.key, hashFlowKey(ev.key), ev.reversed, ev.tcpFlags, ev.hasPayload, ev.payload, ev.payloadLen);
+            nextDecode();
+        });
+        validator.finish(collect);
+        st = validator.getStats();
+    }
+    auto t1 = chrono::steady_clock::now();
+    alerts.close();
+    exporter.stop();
+    if (!exporter.error().empty()) cerr << "[WARN]    Metrics file: " << exporter.error() << endl;
+    if (!ok) cerr << "[WARN]    " << err << " (results cover the packets before it)" << endl;
+    if (!tracePath.empty() && !trace.save(tracePath, err)) {
+        cerr << err << endl;
+        return 1;
+    }
+    if (spanned && (!tracer->writeChrome(spansPrefix + ".json", err) || !tracer->writeFolded(spansPrefix + ".folded", err))) {
+        cerr << err << endl;
+        return 1;
+    }
+
+    double sec = chrono::duration<double>(t1 - t0).count();
+    cout << "===========================================================" << endl;
+    cout << " CAPTURE: " << path << endl;
+    cout << "===========================================================" << endl;
+    cout << "Frames:       " << cs.frames << " (" << cs.tcpPackets << " TCP, " << cs.skipped << " skipped)" << endl;
+    cout << "Throughput:   " << fixed << setprecision(2) << (cs.bytes / 1e9) / sec << " GB/s, "
+         << (cs.frames / 1e6) / sec << " Mpps (" << setprecision(3) << sec << " s"
+         << (threads ? ", " + to_string(threads) + " workers" : "") << ")" << endl;
+    if (decodeOnly) {
+        cout << "Checksum:     " << checksum << endl;
+        return ok ? 0 : 2;
+    }
+
+    cout << "Flows:        " << st.flows << " (peak " << st.peakFlows << " in the table";
+    if (timeouts.enabled()) cout << ", " << st.expired << " evicted on timeout";
+    cout << ")" << endl;
+    if (halfOpen)
+        cout << "Half-open:    " << st.halfOpen << " flows admitted to the filter, " << st.promoted
+             << " got past the handshake" << endl;
+    if (!tracePath.empty())
+        cout << "Trace:        " << trace.steps() << " steps of " << trace.flows() << " flows written to " << tracePath << endl;
+    if (!alertLog.path.empty()) {
+        AlertSinkStats as = alerts.stats();
+        cout << "Alert log:    " << as.written << " alerts to " << alertLog.path << " in " << as.batches << " writes";
+        if (as.files > 1) cout << ", " << as.files << " files";
+        cout << ", " << as.dropped << " dropped";
+        if (alertLog.block) cout << ", " << as.waits << " waits for the writer";
+        cout << endl;
+        if (!as.error.empty()) cerr << "[WARN]    Alert log: " << as.error << endl;
+    }
+    if (measured) {
+        cout << "Step latency: p50 " << metrics.latencyQuantile(0.5) << " ns, p99 " << metrics.latencyQuantile(0.99)
+             << " ns, p99.9 " << metrics.latencyQuantile(0.999) << " ns, max " << metrics.latencyQuantile(1.0) << " ns";
+        if (!metricsPath.empty()) cout << " (metrics in " << metricsPath << ")";
+        cout << endl;
+    }
+    if (spanned)
+        cout << "Spans:        " << tracer->recorded() << " recorded (" << setprecision(2) << tracer->ticksPerNs()
+             << " ticks/ns), written to " << spansPrefix << ".json and " << spansPrefix << ".folded" << endl;
+    cout << "-----------------------------------------------------------" << endl;
+    cout << "[SUCCESS] " << st.verdicts[VERDICT_SUCCESS] << " sessions validated and closed cleanly" << endl;
+    cout << "[ALERT]   " << st.verdicts[VERDICT_ALERT] << " security violations (" << st.signatures << " by payload signature, "
+         << st.blocked << " packets dropped after the trap)" << endl;
+    cout << "[WARN]    " << st.verdicts[VERDICT_WARN] << " incomplete sessions (did not close" << (timeouts.enabled() ? " or timed out" : "") << ")" << endl;
+    if (st.verdicts[VERDICT_OVERFLOW])
+        cout << "[OVERFLOW] " << st.verdicts[VERDICT_OVERFLOW] << " flows nested deeper than the inline stack holds" << endl;
+
+    if (!alerted.empty()) {
+        cout << "-----------------------------------------------------------" << endl;
+        cout << "First " << alerted.size() << " flagged flows:" << endl;
+        for (const auto& a : alerted) {
+            cout << "  " << formatFlow(a.first);
+            if (a.second & SCAN_HIT) cout << "  [signature: " << signatures.names[a.second & ~SCAN_HIT] << "]";
+            cout << endl;
+        }
+    }
+    return ok ? 0 : 2;
+}
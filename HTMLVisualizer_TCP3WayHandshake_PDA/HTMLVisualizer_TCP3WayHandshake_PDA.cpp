@@ -1,93 +1,332 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include "../PDACore/pda_trace.h"
 
 using namespace std;
 
-// === DATA STRUCTURES ===
-struct Step {
-    string packetName;
-    string startState; 
-    string endState;
-    string stackAction; 
-    string description; 
-    string analysis;    
-    bool isAttack;
-};
+// === LOGIC ENGINE ===
+// Transitions come from the compiled PDA definition; this file only narrates them.
+// State names ("q0", "q1", "q2", "qtrap") double as the dashboard's node ids.
+PdaTable protocol;
+vector<string> ruleDesc;      // rule id -> short description
+vector<string> ruleAnalysis;  // rule id -> analysis template, {pkt} = packet label
+
+void loadRuleText() {
+    ruleDesc = protocol.ruleTexts({
+        {"handshake",    "Handshake Valid."},
+        {"no_handshake", "VIOLATION: No Handshake."},
+        {"tunnel",       "Traffic Authorized."},
+        {"hijack",       "HIJACK ATTEMPT!"},
+        {"close",        "Session Closed."},
+        {"reset",        "Session Reset."},
+        {"nested_open",  "Nested Tunnel Opened."},
+        {"nested_close", "Nested Tunnel Closed."},
+        {"teardown",     "Teardown."},
+        {"after_close",  "INTRUSION DETECTED."},
+        {"blocked",      "Blocked."},
+    });
+    ruleAnalysis = protocol.ruleTexts({
+        {"handshake",    "Input: SYN. Rule: Transition q0->q1. Action: PUSH Session Token."},
+        {"no_handshake", "Input: {pkt}. Error: Protocol demands SYN first. Rejected."},
+        {"tunnel",       "Input: {pkt}. Stack Check: OK (Token Present). Tunnel Active."},
+        {"hijack",       "CRITICAL: State is q1, but Stack is EMPTY. Session ID missing."},
+        {"close",        "Input: FIN. Stack Check: OK. Action: POP Token, Move to q2."},
+        {"reset",        "Input: RST. Stack Check: OK. Action: POP Token, Move to q2."},
+        {"nested_open",  "Input: SYN inside the Tunnel. Action: PUSH Tunnel Token, stay in q1."},
+        {"nested_close", "Input: {pkt}. Stack Top: Tunnel Token. Action: POP it, stay in q1."},
+        {"teardown",     "Input: {pkt}. State: q2 (Closed). No payload, part of the teardown."},
+        {"after_close",  "State: q2 (Closed). Event: '{pkt}'. Result: No transition allows Data here. Default -> TRAP."},
+        {"blocked",      "System in TRAP state. Traffic dropped."},
+    });
+}
+
+// === BLOCK ENCODING ===
+// Raw DEFLATE (RFC 1951), one block with the fixed Huffman code: greedy LZ77
+// matches over a 32 KiB window found through a hash of the next 3 bytes. The
+// page inflates it with the browser's DecompressionStream("deflate-raw").
+class BitWriter {
+public:
+    explicit BitWriter(vector<uint8_t>& out) : out(out) {}
+
+    void bits(uint32_t v, int n) {
+        acc |= uint64_t(v) << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back(uint8_t(acc));
+            acc >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman codes go out most significant bit first
+    void code(uint32_t c, int n) {
+        uint32_t r = 0;
+        for (int i = 0; i < n; i++) r |= ((c >> i) & 1) << (n - 1 - i);
+        bits(r, n);
+    }
+
+    void flush() {
+        if (count) out.push_back(uint8_t(acc));
+        acc = 0;
+        count = 0;
+    }
 
-struct Scenario {
-    string name;
-    vector<Step> steps;
+private:
+    vector<uint8_t>& out;
+    uint64_t acc = 0;
+    int count = 0;
 };
 
-// === LOGIC ENGINE ===
-Scenario runPDA(string name, vector<string> packets) {
-    Scenario scen;
-    scen.name = name;
-    
-    int state = 0; // 0=q0, 1=q1, 2=q2, 3=qtrap
-    bool hasSession = false;
+void fixedLiteral(BitWriter& w, unsigned sym) {
+    if (sym < 144) w.code(0x30 + sym, 8);
+    else if (sym < 256) w.code(0x190 + sym - 144, 9);
+    else if (sym < 280) w.code(sym - 256, 7);
+    else w.code(0xC0 + sym - 280, 8);
+}
 
-    for (const string& pkt : packets) {
-        Step s;
-        s.packetName = pkt;
-        s.startState = (state == 0 ? "q0" : state == 1 ? "q1" : state == 2 ? "q2" : "qtrap");
-        s.stackAction = "NONE";
-        s.isAttack = false;
-
-        // --- LOGIC ---
-        if (state == 0) {
-            if (pkt == "SYN") {
-                state = 1; hasSession = true;
-                s.endState = "q1"; s.stackAction = "PUSH";
-                s.description = "Handshake Valid.";
-                s.analysis = "Input: SYN. Rule: Transition q0->q1. Action: PUSH Session Token.";
-            } else {
-                state = 3; s.endState = "qtrap"; s.isAttack = true;
-                s.description = "VIOLATION: No Handshake.";
-                s.analysis = "Input: " + pkt + ". Error: Protocol demands SYN first. Rejected.";
-            }
-        }
-        else if (state == 1) {
-            if (pkt == "FIN") {
-                if (hasSession) {
-                    state = 2; hasSession = false;
-                    s.endState = "q2"; s.stackAction = "POP";
-                    s.description = "Session Closed.";
-                    s.analysis = "Input: FIN. Stack Check: OK. Action: POP Token, Move to q2.";
-                }
-            } else {
-                if (hasSession) {
-                    state = 1; s.endState = "q1";
-                    s.description = "Traffic Authorized.";
-                    s.analysis = "Input: " + pkt + ". Stack Check: OK (Token Present). Tunnel Active.";
-                } else {
-                    state = 3; s.endState = "qtrap"; s.isAttack = true;
-                    s.description = "HIJACK ATTEMPT!";
-                    s.analysis = "CRITICAL: State is q1, but Stack is EMPTY. Session ID missing.";
+vector<uint8_t> deflateRaw(const vector<uint8_t>& in) {
+    static const uint16_t LEN_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+                                           67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t LEN_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+                                            1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    const size_t WINDOW = 32768, HASH = 1 << 15;
+    const int CHAIN = 32;
+    const size_t n = in.size();
+
+    vector<uint8_t> out;
+    BitWriter w(out);
+    w.bits(1, 1);   // final block
+    w.bits(1, 2);   // fixed Huffman
+    vector<int32_t> head(HASH, -1), prev(WINDOW, -1);
+    auto hash3 = [&](size_t i) { return ((size_t(in[i]) << 10) ^ (size_t(in[i + 1]) << 5) ^ in[i + 2]) & (HASH - 1); };
+    auto insert = [&](size_t i) {
+        if (i + 2 >= n) return;
+        size_t h = hash3(i);
+        prev[i & (WINDOW - 1)] = head[h];
+        head[h] = int32_t(i);
+    };
+
+    for (size_t i = 0; i < n;) {
+        size_t bestLen = 0, bestDist = 0;
+        if (i + 2 < n) {
+            size_t most = min<size_t>(258, n - i);
+            int32_t cand = head[hash3(i)];
+            for (int c = 0; c < CHAIN && cand >= 0 && i - size_t(cand) <= WINDOW; c++) {
+                size_t len = 0;
+                while (len < most && in[size_t(cand) + len] == in[i + len]) len++;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = i - size_t(cand);
+                    if (len == most) break;
                 }
+                int32_t older = prev[size_t(cand) & (WINDOW - 1)];
+                if (older >= cand) break;   // slot reused by a newer position
+                cand = older;
             }
         }
-        else if (state == 2) {
-            state = 3; s.endState = "qtrap"; s.isAttack = true;
-            s.description = "INTRUSION DETECTED.";
-            s.analysis = "State: q2 (Closed). Event: '" + pkt + "'. Result: No transition allows Data here. Default -> TRAP.";
-        }
-        else {
-            state = 3; s.endState = "qtrap"; s.isAttack = true;
-            s.description = "Blocked.";
-            s.analysis = "System in TRAP state. Traffic dropped.";
+        if (bestLen >= 3) {
+            int lc = 0;
+            while (lc < 28 && LEN_BASE[lc + 1] <= bestLen) lc++;
+            fixedLiteral(w, 257 + unsigned(lc));
+            w.bits(uint32_t(bestLen - LEN_BASE[lc]), LEN_EXTRA[lc]);
+            int dc = 0;
+            while (dc < 29 && DIST_BASE[dc + 1] <= bestDist) dc++;
+            w.code(uint32_t(dc), 5);
+            w.bits(uint32_t(bestDist - DIST_BASE[dc]), DIST_EXTRA[dc]);
+            for (size_t k = 0; k < bestLen; k++) insert(i + k);
+            i += bestLen;
+        } else {
+            fixedLiteral(w, in[i]);
+            insert(i);
+            i++;
         }
+    }
+    fixedLiteral(w, 256);   // end of block
+    w.flush();
+    return out;
+}
+
+void writeBase64(ostream& out, const vector<uint8_t>& in) {
+    static const char DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    string line;
+    for (size_t i = 0; i < in.size(); i += 3) {
+        uint32_t v = uint32_t(in[i]) << 16;
+        if (i + 1 < in.size()) v |= uint32_t(in[i + 1]) << 8;
+        if (i + 2 < in.size()) v |= in[i + 2];
+        line += DIGITS[v >> 18];
+        line += DIGITS[(v >> 12) & 63];
+        line += i + 1 < in.size() ? DIGITS[(v >> 6) & 63] : '=';
+        line += i + 2 < in.size() ? DIGITS[v & 63] : '=';
+    }
+    out << line;
+}
+
+// A JS string literal that is also safe inside a <script> element.
+void writeJsString(ostream& out, string_view s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (c == '<') out << "\\x3C";
+        else if (c == '\n') out << "\\n";
+        else if (uint8_t(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+template <typename T>
+void appendRaw(vector<uint8_t>& buf, const T* p, size_t n) {
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(p);
+    buf.insert(buf.end(), b, b + n * sizeof(T));
+}
+
+// === DATA ===
+// The dashboard is drawn from a step trace (pda_trace.h): a .pdatrace file
+// given with --trace, or the built-in scenarios recorded into one in memory.
+// Recording is one fixed-size row per packet; text is only rendered below.
+void runPDA(TraceWriter& trace, const string& name, const vector<string>& packets) {
+    uint32_t flow = trace.addFlow(name);
+    PdaConfig pda;
+    protocol.reset(pda);
+
+    for (const string& pkt : packets) {
+        Symbol sym = classifyPacket(pkt);
+        PdaTransition t = protocol.step(pda, sym);
+        bool attack = protocol.isTrap(pda.state);
+        trace.step(flow, sym, t, pda, attack ? TRACE_ATTACK : 0, pkt);
+        if (attack) break;
+    }
+}
 
-        scen.steps.push_back(s);
-        if (state == 3) break; 
+// Rule text by the trace's own rule ids (a trace file may come from another
+// definition); a rule this front end has no text for shows its name.
+vector<string> textForTrace(const TraceFile& trace, const vector<string>& text) {
+    vector<string> out;
+    for (int r = 0; r < trace.header().rules; r++) {
+        string name(trace.ruleName(uint8_t(r)));
+        int id = protocol.ruleId(name);
+        out.push_back(id >= 0 ? text[id] : name);
     }
-    return scen;
+    return out;
+}
+
+bool isAttackFlow(const TraceFile& trace, uint64_t f) {
+    return trace.verdict(f) == VERDICT_ALERT || trace.verdict(f) == VERDICT_OVERFLOW;
 }
 
+// === DASHBOARD DATA ===
+// Flows go to the page in blocks of at most BLOCK_FLOWS flows / BLOCK_STEPS
+// steps (a longer flow gets a block of its own), each as two deflated, base64
+// script elements the browser does not run:
+//   i<n>  per flow: u32 steps, u8 verdict, u8 narrated, u16 name length, name
+//   s<n>  u32 flows, u32 steps, u32 labels, u32 flowStart[flows + 1],
+//         u32 label[steps] (into the block's own label list), u16 depth[steps],
+//         u8 state[steps], rule[steps], flags[steps], top[steps],
+//         then per label: u16 length, bytes
+// The page inflates every index block on load for the list and its search, and
+// a step block only when one of its flows is opened. Each step row holds the
+// state and stack it leaves, so seeking anywhere in a flow reads one row.
+// The generator holds one block at a time, however large the trace.
+const size_t BLOCK_FLOWS = 4096;
+const size_t BLOCK_STEPS = 1 << 16;
+
+class BlockWriter {
+public:
+    explicit BlockWriter(ostream& out) : out(out) {}
+
+    void addFlow(const TraceFile& trace, uint64_t f, bool narrated) {
+        uint64_t n = trace.end(f) - trace.begin(f);
+        this->trace = &trace;
+        if (!flowStart.empty() && (flowStart.size() > BLOCK_FLOWS || label.size() + n > BLOCK_STEPS)) flush();
+        if (flowStart.empty()) flowStart.push_back(0);
+
+        string_view name = trace.flowName(f);
+        uint32_t steps = uint32_t(n);
+        uint16_t nameLen = uint16_t(min<size_t>(name.size(), 0xFFFF));
+        appendRaw(index, &steps, 1);
+        index.push_back(uint8_t(trace.verdict(f)));
+        index.push_back(uint8_t(narrated));
+        appendRaw(index, &nameLen, 1);
+        appendRaw(index, name.data(), nameLen);
+
+        for (uint64_t i = trace.begin(f); i < trace.end(f); i++) {
+            uint32_t id = trace.labelId(i);
+            auto it = labelIds.find(id);
+            if (it == labelIds.end()) {
+                it = labelIds.emplace(id, uint32_t(labels.size())).first;
+                labels.push_back(id);
+            }
+            TraceFrame fr = trace.frame(i);
+            label.push_back(it->second);
+            depth.push_back(fr.depth);
+            state.push_back(fr.state);
+            rule.push_back(trace.rule(i));
+            flags.push_back(trace.flags(i));
+            top.push_back(fr.top);
+        }
+        flowStart.push_back(uint32_t(label.size()));
+    }
+
+    void flush() {
+        if (flowStart.empty()) return;
+        vector<uint8_t> buf;
+        uint32_t head[3] = { uint32_t(flowStart.size() - 1), uint32_t(label.size()), uint32_t(labels.size()) };
+        appendRaw(buf, head, 3);
+        appendRaw(buf, flowStart.data(), flowStart.size());
+        appendRaw(buf, label.data(), label.size());
+        appendRaw(buf, depth.data(), depth.size());
+        for (const vector<uint8_t>* col : { &state, &rule, &flags, &top }) appendRaw(buf, col->data(), col->size());
+        for (uint32_t id : labels) {
+            string_view s = trace->text(id);
+            uint16_t len = uint16_t(min<size_t>(s.size(), 0xFFFF));
+            appendRaw(buf, &len, 1);
+            appendRaw(buf, s.data(), len);
+        }
+
+        out << "<script type=\"application/x-pda-block\" id=\"i" << blocks << "\">";
+        writeBase64(out, deflateRaw(index));
+        out << "</script>\n<script type=\"application/x-pda-block\" id=\"s" << blocks << "\">";
+        writeBase64(out, deflateRaw(buf));
+        out << "</script>\n";
+        blocks++;
+
+        index.clear();
+        flowStart.clear();
+        label.clear();
+        depth.clear();
+        for (vector<uint8_t>* col : { &state, &rule, &flags, &top }) col->clear();
+        labels.clear();
+        labelIds.clear();
+    }
+
+    size_t count() const { return blocks; }
+
+private:
+    ostream& out;
+    const TraceFile* trace = nullptr;
+    size_t blocks = 0;
+    vector<uint8_t> index;
+    vector<uint32_t> flowStart, label;
+    vector<uint16_t> depth;
+    vector<uint8_t> state, rule, flags, top;
+    vector<uint32_t> labels;                      // block label -> trace string id
+    unordered_map<uint32_t, uint32_t> labelIds;   // trace string id -> block label
+};
+
 // === HTML GENERATOR ===
-void generateDashboard(const vector<Scenario>& scenarios) {
+// Streams the page: controls, then the flows block by block, then the script.
+// Attack flows are always narrated; of the clean ones every n-th (0 = none).
+void generateDashboard(const TraceFile& trace, int narrateEvery) {
     ofstream f("network_dashboard.html");
     
     f << R"HTML(
@@ -160,6 +399,17 @@ void generateDashboard(const vector<Scenario>& scenarios) {
         .stack-item { width: 70px; height: 25px; margin-bottom: 2px; border-radius: 3px; display: flex; align-items: center; justify-content: center; font-size: 10px; }
         .base { background: #555; color: #aaa; }
         .token { background: #00e5ff; color: black; }
+        .more { background: #333; color: #00e5ff; }
+
+        /* SCENARIO LIST (virtualized) */
+        #search { padding: 8px; background: #1e1e1e; color: white; border: 1px solid #555; border-radius: 5px; }
+        #list-info { font-family: monospace; color: #888; font-size: 11px; }
+        #flow-list { position: relative; height: 270px; overflow-y: auto; border: 1px solid #333; border-radius: 5px; }
+        #flow-rows { position: absolute; top: 0; left: 0; right: 0; }
+        .row { position: absolute; left: 0; right: 0; height: 26px; line-height: 26px; margin: 2px 4px; padding: 0 8px; background: #333; border: 1px solid #555; border-radius: 5px; cursor: pointer; font-size: 12px; font-weight: bold; white-space: nowrap; overflow: hidden; text-overflow: ellipsis; }
+        .row:hover { border-color: #00e5ff; }
+        .row.selected { background: #00e5ff; color: black; }
+        .attack-row { border-left: 4px solid #aa0000; }
         
         #alert { position: absolute; top: 20px; width: 100%; text-align: center; color: red; font-size: 24px; font-weight: bold; display: none; text-shadow: 0 0 10px red;}
     </style>
@@ -170,13 +420,9 @@ void generateDashboard(const vector<Scenario>& scenarios) {
     <div id="container">
         <div id="controls">
             <h3 style="color:#aaa; margin:0">SCENARIOS</h3>
-)HTML";
-
-    for (int i = 0; i < scenarios.size(); i++) {
-        f << "<button onclick=\"loadScenario(" << i << ")\">" << (i+1) << ". " << scenarios[i].name << "</button>\n";
-    }
-
-    f << R"HTML(
+            <input id="search" type="search" placeholder="Search flows or SUCCESS / ALERT / WARN">
+            <span id="list-info">Loading...</span>
+            <div id="flow-list"><div id="flow-spacer"></div><div id="flow-rows"></div></div>
             <div class="control-panel">
                 <span id="step-counter">Step: 0 / 0</span>
                 <input type="range" id="timeline" min="0" max="0" value="0" step="1" oninput="scrub(this.value)">
@@ -212,62 +458,234 @@ void generateDashboard(const vector<Scenario>& scenarios) {
         </div>
     </div>
 
-<script>
-    const scenarios = [
 )HTML";
 
-    for (const auto& scen : scenarios) {
-        f << "{ name: \"" << scen.name << "\", steps: [";
-        for (const auto& step : scen.steps) {
-            f << "{ pkt: \"" << step.packetName << "\", start: \"" << step.startState << "\", end: \"" << step.endState << "\", action: \"" << step.stackAction << "\", desc: \"" << step.description << "\", analysis: \"" << step.analysis << "\", attack: " << (step.isAttack ? "true" : "false") << "},";
-        }
-        f << "]},\n";
+    BlockWriter blocks(f);
+    uint64_t clean = 0;
+    for (uint64_t i = 0; i < trace.flows(); i++) {
+        bool attack = isAttackFlow(trace, i);
+        blocks.addFlow(trace, i, attack || (narrateEvery > 0 && clean++ % uint64_t(narrateEvery) == 0));
     }
+    blocks.flush();
+
+    const TraceHeader& h = trace.header();
+    auto jsArray = [&](const char* name, size_t n, auto text) {
+        f << "        " << name << ": [";
+        for (size_t i = 0; i < n; i++) {
+            if (i) f << ", ";
+            writeJsString(f, text(i));
+        }
+        f << "],\n";
+    };
+    vector<string> desc = textForTrace(trace, ruleDesc);
+    vector<string> analysis = textForTrace(trace, ruleAnalysis);
+    f << "<script>\n    const META = {\n        flows: " << trace.flows() << ", blocks: " << blocks.count()
+      << ", start: " << int(h.start) << ", bottom: " << int(h.bottom) << ", trap: " << int(h.trap) << ",\n";
+    jsArray("states", h.states, [&](size_t i) { return trace.stateName(uint8_t(i)); });
+    jsArray("stack", h.stackSymbols, [&](size_t i) { return trace.stackName(uint8_t(i)); });
+    jsArray("desc", desc.size(), [&](size_t i) { return string_view(desc[i]); });
+    jsArray("analysis", analysis.size(), [&](size_t i) { return string_view(analysis[i]); });
+    f << "    };\n";
 
     f << R"HTML(
-    ];
+    const NOT_NARRATED = "Not narrated (clean flow outside the --narrate-every sample).";
+    const VERDICTS = ["SUCCESS", "ALERT", "WARN", "OVERFLOW"];
+    const PUSH = 0x01, POP = 0x02, ATTACK = 0x04;
+    const ROW_H = 30;          // scenario list row height (px)
+    const CACHED_BLOCKS = 4;   // inflated step blocks kept
+    const TRAP = META.states[META.trap];
+    const NODE_X = { q0: '50px', q1: '310px', q2: '570px' };
 
     let currentScenario = null;
     let stepIndex = 0;
     let isAnimating = false;
     let playInterval = null;
+    let loadToken = 0;
 
     const els = {
-        q0: document.getElementById('q0'), q1: document.getElementById('q1'),
-        q2: document.getElementById('q2'), qtrap: document.getElementById('qtrap'),
+        nodes: { q0: document.getElementById('q0'), q1: document.getElementById('q1'),
+                 q2: document.getElementById('q2'), qtrap: document.getElementById('qtrap') },
         pkt: document.getElementById('packet'), stack: document.getElementById('stack-container'),
         analysis: document.getElementById('analysis-text'), alert: document.getElementById('alert'),
         timeline: document.getElementById('timeline'), counter: document.getElementById('step-counter'),
-        btnPlay: document.getElementById('btn-play')
+        btnPlay: document.getElementById('btn-play'), search: document.getElementById('search'),
+        list: document.getElementById('flow-list'), spacer: document.getElementById('flow-spacer'),
+        rows: document.getElementById('flow-rows'), listInfo: document.getElementById('list-info')
     };
 
-    function loadScenario(idx) {
+    function esc(s) {
+        return String(s).replace(/[&<>"]/g, c => ({ '&': '&amp;', '<': '&lt;', '>': '&gt;', '"': '&quot;' })[c]);
+    }
+
+    // --- BLOCKS ---
+    async function inflate(id) {
+        const text = atob(document.getElementById(id).textContent);
+        const bytes = new Uint8Array(text.length);
+        for (let i = 0; i < text.length; i++) bytes[i] = text.charCodeAt(i);
+        const stream = new Blob([bytes]).stream().pipeThrough(new DecompressionStream('deflate-raw'));
+        return new Response(stream).arrayBuffer();
+    }
+
+    // Per-flow index, filled block by block on load
+    const flows = {
+        name: new Array(META.flows), key: new Array(META.flows), steps: new Uint32Array(META.flows),
+        verdict: new Uint8Array(META.flows), narrated: new Uint8Array(META.flows),
+        block: new Uint32Array(META.flows), local: new Uint32Array(META.flows)
+    };
+    let loaded = 0;
+
+    async function loadIndex() {
+        const text = new TextDecoder();
+        for (let b = 0; b < META.blocks; b++) {
+            const buf = await inflate('i' + b);
+            const v = new DataView(buf);
+            for (let at = 0, k = 0; at < buf.byteLength; k++) {
+                const f = loaded++;
+                flows.steps[f] = v.getUint32(at, true);
+                flows.verdict[f] = v.getUint8(at + 4);
+                flows.narrated[f] = v.getUint8(at + 5);
+                const len = v.getUint16(at + 6, true);
+                flows.name[f] = text.decode(new Uint8Array(buf, at + 8, len));
+                flows.key[f] = flows.name[f].toLowerCase();
+                flows.block[f] = b;
+                flows.local[f] = k;
+                at += 8 + len;
+            }
+            applyFilter();
+            if (b === 0 && loaded > 0) loadScenario(0);
+        }
+    }
+
+    const blockCache = new Map();   // block -> columns, least recently used first
+
+    async function stepBlock(b) {
+        if (blockCache.has(b)) {
+            const hit = blockCache.get(b);
+            blockCache.delete(b);
+            blockCache.set(b, hit);
+            return hit;
+        }
+        const buf = await inflate('s' + b);
+        const v = new DataView(buf);
+        const nf = v.getUint32(0, true), ns = v.getUint32(4, true), nl = v.getUint32(8, true);
+        let at = 12;
+        const take = (Type, n) => { const a = new Type(buf, at, n); at += n * Type.BYTES_PER_ELEMENT; return a; };
+        const blk = { start: take(Uint32Array, nf + 1), label: take(Uint32Array, ns), depth: take(Uint16Array, ns),
+                      state: take(Uint8Array, ns), rule: take(Uint8Array, ns), flags: take(Uint8Array, ns),
+                      top: take(Uint8Array, ns), labels: [] };
+        const text = new TextDecoder();
+        for (let i = 0; i < nl; i++) {
+            const len = v.getUint16(at, true);
+            blk.labels.push(text.decode(new Uint8Array(buf, at + 2, len)));
+            at += 2 + len;
+        }
+        blockCache.set(b, blk);
+        if (blockCache.size > CACHED_BLOCKS) blockCache.delete(blockCache.keys().next().value);
+        return blk;
+    }
+
+    // --- SCENARIO LIST (virtualized: only the visible rows exist) ---
+    let filtered = new Uint32Array(0);
+
+    function applyFilter() {
+        const q = els.search.value.trim().toLowerCase();
+        const verdict = VERDICTS.findIndex(v => v.toLowerCase() === q);
+        const out = new Uint32Array(loaded);
+        let n = 0;
+        for (let f = 0; f < loaded; f++)
+            if (!q || flows.verdict[f] === verdict || flows.key[f].includes(q)) out[n++] = f;
+        filtered = out.subarray(0, n);
+        els.spacer.style.height = (n * ROW_H) + 'px';
+        els.listInfo.innerText = n + " of " + META.flows + " flows" + (loaded < META.flows ? " (loading...)" : "");
+        renderList();
+    }
+
+    function renderList() {
+        const first = Math.floor(els.list.scrollTop / ROW_H);
+        const last = Math.min(filtered.length, first + Math.ceil(els.list.clientHeight / ROW_H) + 1);
+        const current = currentScenario ? currentScenario.flow : -1;
+        let html = '';
+        for (let r = first; r < last; r++) {
+            const f = filtered[r];
+            const cls = 'row' + (f === current ? ' selected' : '') + (flows.verdict[f] === 1 || flows.verdict[f] === 3 ? ' attack-row' : '');
+            html += '<div class="' + cls + '" style="top:' + (r * ROW_H) + 'px" onclick="loadScenario(' + f + ')">' +
+                    (f + 1) + '. ' + esc(flows.name[f]) + '</div>';
+        }
+        els.rows.innerHTML = html;
+    }
+
+    // --- STEPS (one row each, no replay) ---
+    function stepAt(k) {   // k-th step (1-based) of the current scenario
+        const s = currentScenario, b = s.blk, i = s.begin + k - 1;
+        const pkt = b.labels[b.label[i]];
+        const r = b.rule[i];
+        return {
+            pkt: pkt,
+            start: META.states[k > 1 ? b.state[i - 1] : META.start],
+            end: META.states[b.state[i]],
+            action: (b.flags[i] & PUSH) ? 'PUSH' : (b.flags[i] & POP) ? 'POP' : 'NONE',
+            desc: s.narrated ? META.desc[r] : null,
+            analysis: s.narrated ? META.analysis[r].replace('{pkt}', () => pkt) : null,
+            attack: (b.flags[i] & ATTACK) !== 0
+        };
+    }
+
+    function frameAt(k) {   // configuration after k steps
+        if (k === 0) return { state: META.states[META.start], top: META.bottom, depth: 1 };
+        const b = currentScenario.blk, i = currentScenario.begin + k - 1;
+        return { state: META.states[b.state[i]], top: b.top[i], depth: b.depth[i] };
+    }
+
+    // Bottom marker, up to 4 entries above it (the top one named), "+n" for the rest
+    function drawStack(fr) {
+        if (fr.depth === 0) { els.stack.innerHTML = ''; return; }
+        let html = '<div class="stack-item base">' + esc(META.stack[META.bottom]) + '</div>';
+        const above = fr.depth - 1, shown = Math.min(above, 4);
+        if (above > shown) html += '<div class="stack-item more">+' + (above - shown) + '</div>';
+        for (let j = 0; j < shown; j++)
+            html += '<div class="stack-item token">' + (j === shown - 1 ? esc(META.stack[fr.top] || 'EMPTY') : '&middot;') + '</div>';
+        els.stack.innerHTML = html;
+    }
+
+    function showFrame(k) {
+        const fr = frameAt(k);
+        for (const id in els.nodes) els.nodes[id].className = 'node';
+        els.alert.style.display = 'none';
+        if (fr.state === TRAP) {
+            els.nodes.qtrap.classList.add('trap-active');
+            els.alert.style.display = 'block';
+        } else if (els.nodes[fr.state]) {
+            els.nodes[fr.state].classList.add('active');
+        }
+        drawStack(fr);
+    }
+
+    async function loadScenario(idx) {
         stopPlay();
-        currentScenario = scenarios[idx];
+        const token = ++loadToken;
+        const blk = await stepBlock(flows.block[idx]);
+        if (token !== loadToken) return;
+        const local = flows.local[idx];
+        currentScenario = { flow: idx, name: flows.name[idx], narrated: flows.narrated[idx] !== 0,
+                            blk: blk, begin: blk.start[local], steps: blk.start[local + 1] - blk.start[local] };
         stepIndex = 0;
-        els.timeline.max = currentScenario.steps.length;
+        isAnimating = false;
+        els.timeline.max = currentScenario.steps;
         els.timeline.value = 0;
         updateCounter();
         
         resetVisuals();
-        els.analysis.innerHTML = "Loaded: " + currentScenario.name + "<br>Ready to analyze.";
-        
-        document.querySelectorAll('#controls button').forEach((b, i) => {
-             b.classList.remove('active');
-        });
-        document.querySelectorAll('#controls button')[idx].classList.add('active');
+        els.analysis.innerHTML = "Loaded: " + esc(currentScenario.name) + " [" + VERDICTS[flows.verdict[idx]] + "]<br>Ready to analyze.";
+        renderList();
     }
 
     function resetVisuals() {
-        els.q0.className = 'node active'; els.q1.className = 'node';
-        els.q2.className = 'node'; els.qtrap.className = 'node';
         els.pkt.style.opacity = 0; els.pkt.style.left = '50px'; els.pkt.style.top = '100px';
-        els.alert.style.display = 'none';
-        els.stack.innerHTML = '<div class="stack-item base">Z0</div>';
+        showFrame(0);
     }
 
     function updateCounter() {
-        els.counter.innerText = "Step: " + stepIndex + " / " + currentScenario.steps.length;
+        els.counter.innerText = "Step: " + stepIndex + " / " + currentScenario.steps;
     }
 
     // --- PLAYBACK CONTROLS ---
@@ -280,8 +698,9 @@ void generateDashboard(const vector<Scenario>& scenarios) {
     }
 
     function startPlay() {
+        if (!currentScenario) return;
         // If already at end, reset to start
-        if(stepIndex >= currentScenario.steps.length) {
+        if(stepIndex >= currentScenario.steps) {
             resetSim();
         }
         
@@ -289,7 +708,7 @@ void generateDashboard(const vector<Scenario>& scenarios) {
         els.btnPlay.style.background = "#ff9800"; // Orange
         
         playInterval = setInterval(() => {
-            if(stepIndex >= currentScenario.steps.length) {
+            if(stepIndex >= currentScenario.steps) {
                 stopPlay();
             } else if (!isAnimating) {
                 playNext();
@@ -309,60 +728,36 @@ void generateDashboard(const vector<Scenario>& scenarios) {
         els.btnPlay.style.background = "#9c27b0"; // Purple
     }
 
+    // O(1): the step row already holds the state and stack to show
     function scrub(val) {
+        if (!currentScenario) return;
         stopPlay(); // Stop if dragging
         stepIndex = parseInt(val);
         updateCounter();
         isAnimating = false; 
         
         resetVisuals();
+        showFrame(stepIndex);
         
         if (stepIndex === 0) {
             els.analysis.innerHTML = "Reset to start.";
             return;
         }
 
-        let lastState = 'q0';
-        
-        for(let i = 0; i < stepIndex; i++) {
-            const step = currentScenario.steps[i];
-            
-            if(step.action === 'PUSH') {
-                const t = document.createElement('div'); t.className = 'stack-item token'; t.innerText = 'SESSION';
-                els.stack.appendChild(t);
-            } else if(step.action === 'POP') {
-                const tokens = document.querySelectorAll('.token');
-                if(tokens.length > 0) tokens[tokens.length-1].remove();
-            }
-            lastState = step.end;
-        }
-
-        const currentStep = currentScenario.steps[stepIndex - 1];
-        
-        els.q0.classList.remove('active'); els.q1.classList.remove('active');
-        els.q2.classList.remove('active'); els.qtrap.classList.remove('active');
-        
-        if(lastState === 'q1') els.q1.classList.add('active');
-        else if(lastState === 'q2') els.q2.classList.add('active');
-        else if(lastState === 'qtrap') {
-            els.qtrap.classList.add('trap-active');
-            els.alert.style.display = 'block';
-        } else {
-            els.q0.classList.add('active');
-        }
-
+        const currentStep = stepAt(stepIndex);
         els.analysis.innerHTML = "<span style='color:white'>History:</span> Jumped to Step " + stepIndex + ".<br>" + 
-                                 "<span style='color:#00e5ff'>Last Event:</span> " + currentStep.desc;
+                                 "<span style='color:#00e5ff'>Last Event:</span> " + esc(currentStep.desc || currentStep.start + " -> " + currentStep.end);
     }
 
     function playNext() {
-        if (!currentScenario || stepIndex >= currentScenario.steps.length || isAnimating) return;
+        if (!currentScenario || stepIndex >= currentScenario.steps || isAnimating) return;
         
         stepIndex++;
         els.timeline.value = stepIndex;
         updateCounter();
 
-        const step = currentScenario.steps[stepIndex - 1];
+        const step = stepAt(stepIndex);
+        const shown = stepIndex;
         isAnimating = true;
 
         // Visuals
@@ -371,43 +766,22 @@ void generateDashboard(const vector<Scenario>& scenarios) {
         els.pkt.style.backgroundColor = step.attack ? '#ff3d00' : '#ffea00';
         els.pkt.style.color = step.attack ? 'white' : 'black';
         
-        if(step.start === 'q0') { els.pkt.style.left = '50px'; els.pkt.style.top = '100px'; }
-        if(step.start === 'q1') { els.pkt.style.left = '310px'; els.pkt.style.top = '100px'; }
-        if(step.start === 'q2') { els.pkt.style.left = '570px'; els.pkt.style.top = '100px'; }
+        if (NODE_X[step.start]) { els.pkt.style.left = NODE_X[step.start]; els.pkt.style.top = '100px'; }
         els.pkt.style.opacity = 1;
         void els.pkt.offsetWidth; 
 
         els.pkt.style.transition = 'all 0.8s cubic-bezier(0.25, 1, 0.5, 1)';
         
-        if(step.end === 'q1') els.pkt.style.left = '310px';
-        else if(step.end === 'q2') els.pkt.style.left = '570px';
-        else if(step.end === 'qtrap') { els.pkt.style.left = '310px'; els.pkt.style.top = '275px'; }
+        if (step.end === TRAP) { els.pkt.style.left = '310px'; els.pkt.style.top = '275px'; }
+        else if (NODE_X[step.end]) els.pkt.style.left = NODE_X[step.end];
 
-        els.analysis.innerHTML = "<span style='color:white'>Processing:</span> " + step.pkt + "<br><span style='color:#00e5ff'>Theory:</span> " + step.analysis;
+        els.analysis.innerHTML = "<span style='color:white'>Processing:</span> " + esc(step.pkt) + "<br><span style='color:#00e5ff'>Theory:</span> " + esc(step.analysis || NOT_NARRATED);
 
         setTimeout(() => {
-            els.q0.classList.remove('active'); els.q1.classList.remove('active');
-            els.q2.classList.remove('active');
-
-            if(step.end === 'q1') els.q1.classList.add('active');
-            else if(step.end === 'q2') els.q2.classList.add('active');
-            else if(step.end === 'qtrap') {
-                els.qtrap.classList.add('trap-active');
-                els.alert.style.display = 'block';
-                isAnimating = false;
-                return;
-            }
-
-            if(step.action === 'PUSH') {
-                const t = document.createElement('div'); t.className = 'stack-item token'; t.innerText = 'SESSION';
-                els.stack.appendChild(t);
-            } else if(step.action === 'POP') {
-                const tokens = document.querySelectorAll('.token');
-                if(tokens.length > 0) tokens[tokens.length-1].remove();
-            }
-
-            els.pkt.style.opacity = 0;
             isAnimating = false;
+            if (stepIndex !== shown) return;   // scrubbed meanwhile
+            showFrame(stepIndex);
+            if (step.end !== TRAP) els.pkt.style.opacity = 0;
         }, 800);
     }
 
@@ -420,8 +794,15 @@ void generateDashboard(const vector<Scenario>& scenarios) {
         els.analysis.innerHTML = "Reset complete."; 
     }
     
+    els.search.addEventListener('input', () => { els.list.scrollTop = 0; applyFilter(); });
+    els.list.addEventListener('scroll', renderList);
+
     // AUTO LOAD
-    loadScenario(0); 
+    if (typeof DecompressionStream === 'undefined') {
+        els.analysis.innerHTML = "This browser cannot inflate the embedded data (DecompressionStream is missing).";
+    } else {
+        loadIndex();
+    }
 </script>
 </body>
 </html>
@@ -430,13 +811,42 @@ void generateDashboard(const vector<Scenario>& scenarios) {
     cout << "Dashboard Generated: network_dashboard.html" << endl;
 }
 
-int main() {
-    vector<Scenario> all;
-    all.push_back(runPDA("Web Browsing (Safe)", {"SYN", "ACK", "HTTP_GET", "FIN"}));
-    all.push_back(runPDA("SSH Session (Safe)", {"SYN", "ACK", "SSH_KEY", "ENCRYPTED_DATA", "FIN"}));
-    all.push_back(runPDA("Session Hijack (Attack)", {"SYN", "ACK", "SSH_KEY", "FIN", "ROOT_CMD"}));
-    all.push_back(runPDA("Nmap Scan (Attack)", {"FIN"}));
+int main(int argc, char** argv) {
+    string err;
+    if (!protocol.load(pdaPathFromArgs(argc, argv), err)) {
+        cerr << err << endl;
+        return 1;
+    }
+    loadRuleText();
+    int narrateEvery = 1;
+    string tracePath;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (string(argv[i]) == "--narrate-every") narrateEvery = atoi(argv[i + 1]);
+        if (string(argv[i]) == "--trace") tracePath = argv[i + 1];
+    }
+
+    TraceFile trace;
+    string recorded;
+    if (!tracePath.empty()) {
+        if (!trace.open(tracePath, err)) {
+            cerr << err << endl;
+            return 1;
+        }
+    } else {
+        TraceWriter writer(protocol);
+        runPDA(writer, "Web Browsing (Safe)", {"SYN", "ACK", "HTTP_GET", "FIN"});
+        runPDA(writer, "SSH Session (Safe)", {"SYN", "ACK", "SSH_KEY", "ENCRYPTED_DATA", "FIN"});
+        runPDA(writer, "Session Hijack (Attack)", {"SYN", "ACK", "SSH_KEY", "FIN", "ROOT_CMD"});
+        runPDA(writer, "Nmap Scan (Attack)", {"FIN"});
+        ostringstream buf;
+        writer.write(buf);
+        recorded = buf.str();
+        if (!trace.view(reinterpret_cast<const uint8_t*>(recorded.data()), recorded.size(), err)) {
+            cerr << err << endl;
+            return 1;
+        }
+    }
 
-    generateDashboard(all);
+    generateDashboard(trace, narrateEvery);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,152 @@
+#pragma once
+// === HALF-OPEN FLOW FILTER ===
+// Admission layer in front of the flow table. A flow that has only started its
+// handshake (SYN, SYN+ACK: the definition's 'handshake' states) is one 4-byte
+// entry of a cuckoo filter instead of a 64-byte slot plus a timer; it gets a
+// slot once it gets past the handshake. A SYN flood therefore fills a fixed
+// amount of memory and never reaches the table.
+//
+// Partial-key cuckoo hashing (Fan et al., 2014): buckets of 4 entries, each
+// entry a 24-bit fingerprint plus an 8-bit caller tag. Flows are given by a
+// 64-bit hash (hashFlowKey64): the low bits pick bucket i1, the top 24 bits
+// are the fingerprint, and i2 = i1 ^ H(fingerprint), so an entry can be moved
+// to its other bucket from the fingerprint alone.
+//
+// Two generations age the entries out: new entries go to the current one, and
+// rotate() drops the previous generation and starts an empty one. The owner
+// rotates once per handshake timeout, and the filter rotates by itself when
+// the current generation reaches 90% load, so memory never grows.
+//
+// False positives: a packet of a flow that was never admitted matches a stored
+// fingerprint with probability <= 2 buckets * 4 entries / 2^24 ~ 4.8e-7 per
+// full generation, ~9.5e-7 with both full. Such a packet continues the other
+// flow's handshake instead of starting from the start state. There are no
+// false negatives, but entries dropped on rotation are forgotten, so a
+// handshake slower than the rotation period starts over from the start state.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class HalfOpenFilter {
+public:
+    static constexpr int BUCKET = 4;
+    static constexpr int MAX_KICKS = 500;
+
+    // Room for at least `capacity` flows per generation; 0 = disabled.
+    explicit HalfOpenFilter(size_t capacity = 0) {
+        if (capacity == 0) return;
+        size_t buckets = 1;
+        while (buckets * BUCKET * 9 < capacity * 10) buckets <<= 1;
+        mask = buckets - 1;
+        limit = buckets * BUCKET * 9 / 10;
+        for (Generation& g : gens) g.entries.assign(buckets * BUCKET, 0);
+    }
+
+    bool enabled() const { return limit != 0; }
+    size_t size() const { return gens[0].count + gens[1].count; }
+    size_t memoryBytes() const { return (gens[0].entries.size() + gens[1].entries.size()) * sizeof(uint32_t); }
+
+    bool contains(uint64_t h) const {
+        uint32_t fp = fingerprint(h);
+        for (const Generation& g : gens)
+            if (slotOf(g, h, fp) >= 0) return true;
+        return false;
+    }
+
+    // Remove the flow's entry (newest generation first) and hand back its tag.
+    bool take(uint64_t h, uint8_t& tag) {
+        uint32_t fp = fingerprint(h);
+        for (int k = 0; k < 2; k++) {
+            Generation& g = gens[cur ^ k];
+            long i = slotOf(g, h, fp);
+            if (i < 0) continue;
+            tag = uint8_t(g.entries[size_t(i)]);
+            g.entries[size_t(i)] = 0;
+            g.count--;
+            return true;
+        }
+        return false;
+    }
+
+    // Store a flow into the current generation. Entries forgotten on the way (a
+    // rotation, or the rare insert that runs out of kicks) go to dropped(tag).
+    template <typename Fn>
+    void put(uint64_t h, uint8_t tag, Fn&& dropped) {
+        if (gens[cur].count >= limit) rotate(dropped);
+        Generation& g = gens[cur];
+        uint32_t fp = fingerprint(h);
+        uint32_t entry = (fp << 8) | tag;
+        size_t i = h & mask;
+        if (place(g, i, entry) || place(g, alt(i, fp), entry)) return;
+        // Both buckets full: evict a resident to its other bucket, and repeat
+        for (int n = 0; n < MAX_KICKS; n++) {
+            rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+            uint32_t& victim = g.entries[i * BUCKET + (rng >> 62)];
+            uint32_t moved = victim;
+            victim = entry;
+            entry = moved;
+            i = alt(i, entry >> 8);
+            if (place(g, i, entry)) return;
+        }
+        dropped(uint8_t(entry));
+    }
+
+    // Drop the previous generation; the current one becomes the previous.
+    template <typename Fn>
+    void rotate(Fn&& dropped) {
+        Generation& old = gens[cur ^ 1];
+        for (uint32_t& e : old.entries) {
+            if (e) dropped(uint8_t(e));
+            e = 0;
+        }
+        old.count = 0;
+        cur ^= 1;
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const Generation& g : gens)
+            for (uint32_t e : g.entries)
+                if (e) fn(uint8_t(e));
+    }
+
+private:
+    struct Generation {
+        std::vector<uint32_t> entries;   // fingerprint << 8 | tag, 0 = empty
+        size_t count = 0;
+    };
+
+    Generation gens[2];
+    int cur = 0;
+    size_t mask = 0;
+    size_t limit = 0;
+    uint64_t rng = 0x853C49E6748FEA9BULL;
+
+    static uint32_t fingerprint(uint64_t h) {
+        uint32_t fp = uint32_t(h >> 40);
+        return fp ? fp : 1;
+    }
+
+    size_t alt(size_t i, uint32_t fp) const { return (i ^ (fp * 0x5BD1E995u)) & mask; }
+
+    long slotOf(const Generation& g, uint64_t h, uint32_t fp) const {
+        size_t b[2] = { h & mask, alt(h & mask, fp) };
+        for (size_t bi : b)
+            for (int j = 0; j < BUCKET; j++)
+                if ((g.entries[bi * BUCKET + j] >> 8) == fp) return long(bi * BUCKET + j);
+        return -1;
+    }
+
+    bool place(Generation& g, size_t bucket, uint32_t entry) {
+        for (int j = 0; j < BUCKET; j++) {
+            uint32_t& e = g.entries[bucket * BUCKET + j];
+            if (!e) {
+                e = entry;
+                g.count++;
+                return true;
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,339 @@
+#pragma once
+// === ALERT SINK ===
+// Violations leave the validating threads as 64-byte records pushed into a
+// bounded lock-free multi-producer / single-consumer ring; one writer thread
+// drains it in batches and appends them to a log file, so an attack burst
+// costs the validators one ring slot per alert and never a write() or a lock.
+//
+// The ring is Vyukov's bounded queue: every cell carries a sequence number, a
+// producer claims a position with one CAS on the tail and publishes the cell
+// by storing its sequence; the consumer owns the head outright. When the ring
+// is full the sink either drops the record (default: validation never waits)
+// or, with `block`, spins until the writer makes room. Both are counted.
+//
+// The log is NDJSON (one object per alert, names resolved by the writer) or
+// binary (a 16-byte "PDAALRT1" header, then the raw records). It rotates at
+// rotateBytes: path -> path.1 -> ... -> path.<keepFiles>. Records that cannot
+// be written (a failed write, or no log after a failed reopen) count as
+// dropped, and the first such failure is kept in the stats.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "pda_parallel.h"
+
+inline std::string formatEndpoint(const uint32_t* addr, uint16_t port, bool v4) {
+    char buf[64];
+    if (v4) {
+        uint32_t a = addr[3];
+        snprintf(buf, sizeof(buf), "%u.%u.%u.%u:%u", a >> 24, (a >> 16) & 0xFF, (a >> 8) & 0xFF, a & 0xFF, port);
+    } else {
+        snprintf(buf, sizeof(buf), "[%x:%x:%x:%x:%x:%x:%x:%x]:%u",
+                 addr[0] >> 16, addr[0] & 0xFFFF, addr[1] >> 16, addr[1] & 0xFFFF,
+                 addr[2] >> 16, addr[2] & 0xFFFF, addr[3] >> 16, addr[3] & 0xFFFF, port);
+    }
+    return buf;
+}
+
+inline std::string formatFlow(const FlowKey& k) {
+    bool v4 = k.isIpv4();
+    return formatEndpoint(k.src, k.sport, v4) + " <-> " + formatEndpoint(k.dst, k.dport, v4);
+}
+
+// === ALERT RECORD ===
+enum AlertKind : uint8_t { ALERT_PROTOCOL, ALERT_SIGNATURE, ALERT_OVERFLOW };
+
+inline const char* alertKindName(uint8_t k) {
+    static const char* const NAMES[] = { "protocol", "signature", "overflow" };
+    return k <= ALERT_OVERFLOW ? NAMES[k] : "?";
+}
+
+struct AlertRecord {
+    uint64_t tsNanos;     // 8, packet time (FlowAlert::tsNanos)
+    FlowKey  key;         // 40
+    uint8_t  kind;        // AlertKind
+    uint8_t  from;        // state before the packet
+    uint8_t  sym;         // input symbol
+    uint8_t  rule;        // rule that fired
+    int16_t  signature;   // -1 unless kind == ALERT_SIGNATURE
+    uint8_t  origin;      // FlowKey::canonicalize() of the flow's first packet
+    uint8_t  pad;
+    uint32_t source;      // shard / thread that saw it
+    uint32_t reserved;
+};
+static_assert(sizeof(AlertRecord) == 64, "alert records are one cache line (binary log format)");
+
+inline AlertRecord makeAlertRecord(const FlowSlot& s, const FlowAlert& a, uint32_t source = 0) {
+    AlertRecord r{};
+    r.tsNanos = a.tsNanos;
+    r.key = s.key;
+    r.kind = a.overflow ? ALERT_OVERFLOW : a.signature >= 0 ? ALERT_SIGNATURE : ALERT_PROTOCOL;
+    r.from = a.from;
+    r.sym = a.sym;
+    r.rule = a.rule;
+    r.signature = a.signature;
+    r.origin = s.origin;
+    r.source = source;
+    return r;
+}
+
+// === MPSC RING ===
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacityPow2) : cells(capacityPow2), mask(capacityPow2 - 1) {
+        for (size_t i = 0; i < cells.size(); i++) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Any thread. False when the ring is full.
+    bool tryPush(const T& item) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells[pos & mask];
+            size_t seq = c.seq.load(std::memory_order_acquire);
+            intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = item;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;   // the cell a lap ahead is still unread
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // The one consumer: move up to max published items out, in order. A cell
+    // claimed but not yet written stops the batch there.
+    size_t popMany(T* out, size_t max) {
+        size_t n = 0;
+        while (n < max) {
+            Cell& c = cells[head & mask];
+            if (c.seq.load(std::memory_order_acquire) != head + 1) break;
+            out[n++] = c.value;
+            c.seq.store(head + mask + 1, std::memory_order_release);
+            head++;
+        }
+        return n;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    std::vector<Cell> cells;
+    const size_t mask;
+    alignas(64) std::atomic<size_t> tail{0};   // claimed by producers
+    alignas(64) size_t head = 0;               // consumer only
+};
+
+// === SINK ===
+enum AlertFormat { ALERT_NDJSON, ALERT_BINARY };
+
+struct AlertSinkOptions {
+    std::string path;
+    AlertFormat format = ALERT_NDJSON;
+    uint64_t rotateBytes = 64ULL << 20;   // 0 = never rotate
+    int keepFiles = 4;                    // rotated files kept next to the live one
+    size_t capacity = 1 << 16;            // ring slots (power of two)
+    bool block = false;                   // full ring: wait for the writer instead of dropping
+};
+
+struct AlertSinkStats {
+    uint64_t written = 0;    // records in the log
+    uint64_t dropped = 0;    // ring full or log write failed, record lost
+    uint64_t waits = 0;      // ring full, producer waited (block mode)
+    uint64_t batches = 0;    // writes the writer made
+    uint64_t files = 0;      // log files opened (1 + rotations)
+    std::string error;       // first write / reopen failure, empty = none
+};
+
+class AlertSink {
+public:
+    // Names in NDJSON come from the protocol and the signature list.
+    AlertSink(const PdaTable& protocol, const SignatureSet* signatures = nullptr)
+        : protocol(protocol), signatures(signatures) {}
+
+    ~AlertSink() { close(); }
+
+    bool open(const AlertSinkOptions& o, std::string& err) {
+        opt = o;
+        size_t cap = 64;
+        while (cap < opt.capacity) cap <<= 1;
+        ring.reset(new MpscRing<AlertRecord>(cap));
+        if (!openFile(err)) return false;
+        writer = std::thread([this] { run(); });
+        return true;
+    }
+
+    bool isOpen() const { return writer.joinable(); }
+
+    // --- HOT PATH --- any validating thread
+    bool push(const AlertRecord& r) {
+        if (ring->tryPush(r)) return true;
+        if (!opt.block) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        waits.fetch_add(1, std::memory_order_relaxed);
+        unsigned spins = 0;
+        while (!ring->tryPush(r)) backoff(spins);
+        return true;
+    }
+
+    // Drain what was pushed, stop the writer and close the log.
+    void close() {
+        if (!writer.joinable()) return;
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+        if (file) std::fclose(file);
+        file = nullptr;
+    }
+
+    AlertSinkStats stats() const {
+        AlertSinkStats s = counts;
+        s.dropped = dropped.load(std::memory_order_relaxed);
+        s.waits = waits.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    static const size_t BATCH = 256;
+
+    const PdaTable& protocol;
+    const SignatureSet* signatures;
+    AlertSinkOptions opt;
+    std::unique_ptr<MpscRing<AlertRecord>> ring;
+    std::thread writer;
+    std::atomic<bool> stopping{false};
+    alignas(64) std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> waits{0};
+    AlertSinkStats counts;   // writer thread only
+    std::FILE* file = nullptr;
+    uint64_t fileBytes = 0;
+    std::string out;         // one batch, formatted
+
+    void run() {
+        AlertRecord batch[BATCH];
+        unsigned idle = 0;
+        for (;;) {
+            // Read the flag first: records pushed before close() are then seen below
+            bool last = stopping.load(std::memory_order_acquire);
+            size_t n = ring->popMany(batch, BATCH);
+            if (n) {
+                idle = 0;
+                write(batch, n);
+                continue;
+            }
+            if (last) break;
+            if (++idle == 64 && file) std::fflush(file);   // gone quiet: let readers see the tail
+            if (idle < 64) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (file) std::fflush(file);
+    }
+
+    void write(const AlertRecord* r, size_t n) {
+        if (!file) {   // a reopen failed: nothing is logged any more
+            dropped.fetch_add(n, std::memory_order_relaxed);
+            return;
+        }
+        out.clear();
+        if (opt.format == ALERT_BINARY) out.append(reinterpret_cast<const char*>(r), n * sizeof(AlertRecord));
+        else for (size_t i = 0; i < n; i++) appendJson(r[i]);
+        if (std::fwrite(out.data(), 1, out.size(), file) != out.size()) {
+            dropped.fetch_add(n, std::memory_order_relaxed);
+            fail("write to " + opt.path + " failed");
+            return;
+        }
+        fileBytes += out.size();
+        counts.written += n;
+        counts.batches++;
+        if (opt.rotateBytes && fileBytes >= opt.rotateBytes) {
+            std::string err;
+            if (!rotate(err)) fail(err);
+        }
+    }
+
+    void fail(const std::string& err) {
+        if (counts.error.empty()) counts.error = err;
+    }
+
+    bool openFile(std::string& err) {
+        file = std::fopen(opt.path.c_str(), "wb");
+        if (!file) {
+            err = "cannot write " + opt.path;
+            return false;
+        }
+        fileBytes = 0;
+        counts.files++;
+        if (opt.format == ALERT_BINARY) {
+            uint8_t header[16] = { 'P', 'D', 'A', 'A', 'L', 'R', 'T', '1' };
+            uint32_t version = 1, recordSize = sizeof(AlertRecord);
+            std::memcpy(header + 8, &version, 4);
+            std::memcpy(header + 12, &recordSize, 4);
+            if (std::fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+                std::fclose(file);   // a log without its header is unreadable: drop what follows instead
+                file = nullptr;
+                err = "write to " + opt.path + " failed";
+                return false;
+            }
+            fileBytes = sizeof(header);
+        }
+        return true;
+    }
+
+    bool rotate(std::string& err) {
+        std::fclose(file);
+        file = nullptr;
+        for (int i = opt.keepFiles; i >= 1; i--) {
+            std::string from = i == 1 ? opt.path : opt.path + "." + std::to_string(i - 1);
+            std::rename(from.c_str(), (opt.path + "." + std::to_string(i)).c_str());
+        }
+        if (opt.keepFiles < 1) std::remove(opt.path.c_str());
+        return openFile(err);
+    }
+
+    static void appendEscaped(std::string& o, std::string_view s) {
+        for (char c : s) {
+            if (c == '"' || c == '\\') o += '\\';
+            if (static_cast<unsigned char>(c) < 0x20) c = ' ';
+            o += c;
+        }
+    }
+
+    void appendJson(const AlertRecord& r) {
+        out += "{\"ts\":";
+        out += std::to_string(r.tsNanos);
+        out += ",\"flow\":\"";
+        out += formatFlow(r.key);
+        out += "\",\"kind\":\"";
+        out += alertKindName(r.kind);
+        out += "\",\"from\":\"";
+        if (r.from < protocol.states.size()) appendEscaped(out, protocol.states[r.from]);
+        out += "\",\"input\":\"";
+        out += symbolName(Symbol(r.sym));
+        out += "\",\"rule\":\"";
+        if (r.rule < protocol.rules.size()) appendEscaped(out, protocol.rules[r.rule]);
+        out += '"';
+        if (r.signature >= 0 && signatures && size_t(r.signature) < signatures->names.size()) {
+            out += ",\"signature\":\"";
+            appendEscaped(out, signatures->names[size_t(r.signature)]);
+            out += '"';
+        }
+        out += ",\"source\":";
+        out += std::to_string(r.source);
+        out += "}\n";
+    }
+};
@@ -0,0 +1,324 @@
+#pragma once
+// === OFFLINE CAPTURE INGESTION (.pcap / .pcapng) ===
+// The capture file is memory-mapped and walked in place: record headers,
+// Ethernet / VLAN / IPv4 / IPv6 / TCP headers are read straight out of the
+// mapping, and every TCP segment becomes one PacketEvent (flow key, PDA symbol,
+// payload pointer into the mapping). Nothing is copied or allocated per packet.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "pda_flows.h"
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// === MAPPED FILE ===
+// Read-only mapping of a whole file. On Windows the file is read into memory
+// instead, which keeps the parser identical.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path, std::string& err) {
+        close();
+#if defined(_WIN32)
+        std::ifstream f(path, std::ios::binary);
+        if (!f) { err = "Cannot open " + path; return false; }
+        fallback.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        ptr = reinterpret_cast<const uint8_t*>(fallback.data());
+        len = fallback.size();
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { err = "Cannot open " + path; return false; }
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); err = "Cannot stat " + path; return false; }
+        len = size_t(st.st_size);
+        if (len) {
+            void* m = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m == MAP_FAILED) { ::close(fd); err = "Cannot mmap " + path; len = 0; return false; }
+            madvise(m, len, MADV_SEQUENTIAL);   // read-ahead, drop pages behind us
+            ptr = static_cast<const uint8_t*>(m);
+        }
+        ::close(fd);
+#endif
+        return true;
+    }
+
+    void close() {
+#if defined(_WIN32)
+        fallback.clear();
+#else
+        if (ptr) munmap(const_cast<uint8_t*>(ptr), len);
+#endif
+        ptr = nullptr;
+        len = 0;
+    }
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return len; }
+
+private:
+    const uint8_t* ptr = nullptr;
+    size_t len = 0;
+#if defined(_WIN32)
+    std::string fallback;
+#endif
+};
+
+// === BYTE ORDER HELPERS ===
+// Unaligned loads via memcpy (compiles to a single mov) plus swaps.
+inline uint16_t loadU16(const uint8_t* p) { uint16_t v; std::memcpy(&v, p, 2); return v; }
+inline uint32_t loadU32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+inline uint16_t swapU16(uint16_t v) { return uint16_t((v >> 8) | (v << 8)); }
+inline uint32_t swapU32(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+}
+inline uint16_t loadBE16(const uint8_t* p) { return uint16_t((p[0] << 8) | p[1]); }
+inline uint32_t loadBE32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+// === PACKET DECODE ===
+// One decoded TCP segment. payload points into the capture mapping.
+struct PacketEvent {
+    FlowKey key;             // canonical (direction-free) 5-tuple
+    uint64_t tsNanos;        // capture timestamp, ns since epoch
+    const uint8_t* payload;
+    uint32_t payloadLen;     // bytes captured, may be cut short by the snaplen
+    uint8_t tcpFlags;
+    bool hasPayload;         // the IP length says the segment carries data
+    Symbol sym;              // as if sent by the initiator; FlowValidator::onSegment sets the direction
+    bool reversed;           // key endpoints were swapped by canonicalize()
+};
+
+// Link-layer types we can walk to the IP header.
+enum LinkType : uint32_t { LINK_ETHERNET = 1, LINK_RAW = 101, LINK_LINUX_SLL = 113, LINK_IPV4 = 228, LINK_IPV6 = 229 };
+
+// Decode one frame down to TCP. Returns false for anything that is not a
+// complete-enough TCP segment (ARP, UDP, truncated, non-first fragments ...).
+inline bool decodeTcpFrame(uint32_t linkType, const uint8_t* p, uint32_t capLen, PacketEvent& ev) {
+    const uint8_t* end = p + capLen;
+    uint16_t etherType;
+
+    switch (linkType) {
+        case LINK_ETHERNET:
+            if (capLen < 14) return false;
+            etherType = loadBE16(p + 12);
+            p += 14;
+            // 802.1Q / 802.1ad VLAN tags
+            while ((etherType == 0x8100 || etherType == 0x88A8) && end - p >= 4) {
+                etherType = loadBE16(p + 2);
+                p += 4;
+            }
+            break;
+        case LINK_LINUX_SLL:
+            if (capLen < 16) return false;
+            etherType = loadBE16(p + 14);
+            p += 16;
+            break;
+        case LINK_RAW:
+        case LINK_IPV4:
+        case LINK_IPV6:
+            if (capLen < 1) return false;
+            etherType = ((p[0] >> 4) == 6) ? 0x86DD : 0x0800;
+            break;
+        default:
+            return false;
+    }
+
+    const uint8_t* tcp;
+    uint32_t ipPayload;
+    if (etherType == 0x0800) {
+        if (end - p < 20 || (p[0] >> 4) != 4) return false;
+        uint32_t ihl = uint32_t(p[0] & 0x0F) * 4;
+        if (ihl < 20 || p[9] != 6) return false;                   // TCP only
+        if (loadBE16(p + 6) & 0x1FFF) return false;                // non-first fragment
+        uint32_t total = loadBE16(p + 2);
+        if (total < ihl) return false;
+        ev.key = FlowKey::ipv4(loadBE32(p + 12), loadBE32(p + 16), 0, 0);
+        tcp = p + ihl;
+        ipPayload = total - ihl;
+    } else if (etherType == 0x86DD) {
+        if (end - p < 40 || (p[0] >> 4) != 6) return false;
+        uint8_t next = p[6];
+        ipPayload = loadBE16(p + 4);
+        const uint8_t* src = p + 8;
+        const uint8_t* dst = p + 24;
+        tcp = p + 40;
+        // Skip hop-by-hop / routing / destination options / fragment headers
+        for (int hops = 0; hops < 8 && next != 6; hops++) {
+            if (end - tcp < 8) return false;
+            uint32_t extLen;
+            if (next == 0 || next == 43 || next == 60) extLen = (uint32_t(tcp[1]) + 1) * 8;
+            else if (next == 44) {
+                if (loadBE16(tcp + 2) & 0xFFF8) return false;      // non-first fragment
+                extLen = 8;
+            }
+            else return false;
+            if (extLen > ipPayload) return false;
+            next = tcp[0];
+            tcp += extLen;
+            ipPayload -= extLen;
+        }
+        if (next != 6) return false;
+        ev.key = FlowKey::ipv6(src, dst, 0, 0);
+    } else {
+        return false;
+    }
+
+    if (end - tcp < 20) return false;
+    uint32_t tcpLen = uint32_t(tcp[12] >> 4) * 4;
+    if (tcpLen < 20 || tcpLen > ipPayload) return false;
+    ev.key.sport = loadBE16(tcp);
+    ev.key.dport = loadBE16(tcp + 2);
+    ev.tcpFlags = tcp[13];
+    ev.payload = tcp + tcpLen;
+    ev.payloadLen = ipPayload - tcpLen;
+    // Ethernet padding / snaplen: never hand out bytes beyond the capture
+    if (ev.payload > end) ev.payload = end;
+    if (ev.payloadLen > uint32_t(end - ev.payload)) ev.payloadLen = uint32_t(end - ev.payload);
+    ev.hasPayload = ipPayload != tcpLen;
+    ev.sym = tcpInput(ev.tcpFlags, ev.hasPayload, false);
+    ev.reversed = ev.key.canonicalize();
+    return true;
+}
+
+// === CAPTURE READER ===
+struct CaptureStats {
+    uint64_t bytes = 0;        // size of the capture file
+    uint64_t frames = 0;       // packet records in the file
+    uint64_t tcpPackets = 0;   // records that decoded to a TCP segment
+    uint64_t skipped = 0;      // non-TCP, truncated or unsupported link type
+};
+
+// Walk every packet record and call fn(const PacketEvent&) for each TCP segment.
+// Returns false (with err) if the file is not a pcap / pcapng capture or is
+// cut off mid-record; everything up to that point has already been delivered.
+template <typename Fn>
+bool readCapture(const uint8_t* data, size_t size, CaptureStats& stats, std::string& err, Fn&& fn) {
+    stats.bytes = size;
+    if (size < 4) { err = "File too short to be a capture"; return false; }
+    uint32_t magic = loadU32(data);
+    PacketEvent ev;
+
+    // --- classic pcap ---
+    if (magic == 0xA1B2C3D4 || magic == 0xD4C3B2A1 || magic == 0xA1B23C4D || magic == 0x4D3CB2A1) {
+        if (size < 24) { err = "Truncated pcap header"; return false; }
+        bool swap = (magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1);
+        bool nanos = (magic == 0xA1B23C4D || magic == 0x4D3CB2A1);
+        auto u32 = [swap](const uint8_t* p) { uint32_t v = loadU32(p); return swap ? swapU32(v) : v; };
+        uint32_t linkType = u32(data + 20) & 0x0FFFFFFF;
+        size_t off = 24;
+        while (off + 16 <= size) {
+            const uint8_t* rec = data + off;
+            uint32_t capLen = u32(rec + 8);
+            if (capLen > size - off - 16) { err = "Truncated pcap record"; return false; }
+            stats.frames++;
+            if (decodeTcpFrame(linkType, rec + 16, capLen, ev)) {
+                ev.tsNanos = uint64_t(u32(rec)) * 1000000000ULL + uint64_t(u32(rec + 4)) * (nanos ? 1 : 1000);
+                stats.tcpPackets++;
+                fn(ev);
+            } else {
+                stats.skipped++;
+            }
+            off += 16 + capLen;
+        }
+        return true;
+    }
+
+    // --- pcapng ---
+    if (magic == 0x0A0D0D0A) {
+        bool swap = false;
+        std::vector<uint32_t> ifLink;      // per interface in the current section
+        std::vector<uint64_t> ifUnitsPerSec;
+        size_t off = 0;
+        auto u16 = [&swap](const uint8_t* p) { uint16_t v = loadU16(p); return swap ? swapU16(v) : v; };
+        auto u32 = [&swap](const uint8_t* p) { uint32_t v = loadU32(p); return swap ? swapU32(v) : v; };
+
+        while (off + 12 <= size) {
+            const uint8_t* blk = data + off;
+            uint32_t type = loadU32(blk);
+            if (type == 0x0A0D0D0A) {
+                // Section header: byte-order magic decides endianness for the section
+                if (off + 16 > size) break;
+                uint32_t bom = loadU32(blk + 8);
+                if (bom == 0x1A2B3C4D) swap = false;
+                else if (bom == 0x4D3C2B1A) swap = true;
+                else { err = "Bad pcapng byte-order magic"; return false; }
+                ifLink.clear();
+                ifUnitsPerSec.clear();
+            } else {
+                type = u32(blk);
+            }
+            uint32_t blockLen = u32(blk + 4);
+            if (blockLen < 12 || (blockLen & 3) || blockLen > size - off) { err = "Truncated pcapng block"; return false; }
+
+            if (type == 1 && blockLen >= 20) {
+                // Interface description: link type + optional if_tsresol
+                ifLink.push_back(u16(blk + 8));
+                uint64_t units = 1000000;
+                for (size_t o = 16; o + 4 <= blockLen - 4;) {
+                    uint16_t code = u16(blk + o), olen = u16(blk + o + 2);
+                    if (code == 0) break;
+                    if (code == 9 && olen >= 1) {
+                        uint8_t r = blk[o + 4];
+                        int exp = r & 0x7F;
+                        // The units per second must fit 64 bits
+                        if (exp > ((r & 0x80) ? 63 : 19)) { err = "Bad if_tsresol"; return false; }
+                        units = 1;
+                        for (int i = 0; i < exp; i++) units *= (r & 0x80) ? 2 : 10;
+                    }
+                    o += 4 + ((olen + 3u) & ~3u);
+                }
+                ifUnitsPerSec.push_back(units);
+            } else if (type == 6 && blockLen >= 32) {
+                // Enhanced packet block
+                uint32_t ifId = u32(blk + 8);
+                uint32_t capLen = u32(blk + 20);
+                if (capLen > blockLen - 32) { err = "Bad pcapng packet length"; return false; }
+                stats.frames++;
+                if (ifId < ifLink.size() && decodeTcpFrame(ifLink[ifId], blk + 28, capLen, ev)) {
+                    uint64_t ts = (uint64_t(u32(blk + 12)) << 32) | u32(blk + 16);
+                    uint64_t units = ifUnitsPerSec[ifId];
+                    // 128-bit product: finer than ns resolutions overflow (ts % units) * 1e9
+                    ev.tsNanos = (units == 1000000000ULL) ? ts
+                                 : uint64_t((unsigned __int128)(ts / units) * 1000000000ULL +
+                                            (unsigned __int128)(ts % units) * 1000000000ULL / units);
+                    stats.tcpPackets++;
+                    fn(ev);
+                } else {
+                    stats.skipped++;
+                }
+            } else if (type == 3 && blockLen >= 16) {
+                // Simple packet block: interface 0, no timestamp
+                uint32_t capLen = blockLen - 16;
+                uint32_t origLen = u32(blk + 8);
+                if (origLen < capLen) capLen = origLen;
+                stats.frames++;
+                if (!ifLink.empty() && decodeTcpFrame(ifLink[0], blk + 12, capLen, ev)) {
+                    ev.tsNanos = 0;
+                    stats.tcpPackets++;
+                    fn(ev);
+                } else {
+                    stats.skipped++;
+                }
+            }
+            off += blockLen;
+        }
+        return true;
+    }
+
+    err = "Not a pcap or pcapng file";
+    return false;
+}
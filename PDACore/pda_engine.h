@@ -0,0 +1,383 @@
+#pragma once
+// === SHARED PDA ENGINE ===
+// One table-driven PDA for every front end. A protocol is written as a small
+// text definition (states, input symbols, stack symbols, push/pop rules), which
+// is compiled into a dense [state][symbol][stackTop] transition table. Running
+// a flow is then one table lookup per packet on an inline, run-length
+// compressed stack of IDs.
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "pda_symbols.h"
+
+// State / stack IDs of the built-in TCP handshake definition below. The
+// visualizers draw their diagrams with these (same 0..3 encoding as before).
+enum PdaState : uint8_t { Q0_LISTEN, Q1_ACTIVE, Q2_CLOSED, Q_TRAP };
+enum StackSym : uint8_t { STK_Z0, STK_SESSION, STK_TUNNEL };
+
+constexpr int PDA_STACK_RUNS = 5;     // distinct runs the inline stack holds
+constexpr int PDA_RUN_MAX = 255;      // copies of one symbol a run holds
+
+// A flow's whole run-time configuration: state byte + inline stack of IDs,
+// 13 bytes. The stack is run-length compressed, so repeated tokens (sessions
+// tunnelled inside sessions) cost one run; a push that fits in no run is an
+// explicit overflow, never an allocation.
+struct PdaConfig {
+    uint8_t state;
+    uint8_t runs;                   // runs on the stack, bottom marker's included
+    uint8_t overflow;               // 1 once a push did not fit (the flow is trapped)
+    uint8_t sym[PDA_STACK_RUNS];    // run i is count[i] copies of sym[i], run 0 at the bottom
+    uint8_t count[PDA_STACK_RUNS];
+
+    size_t depth() const {
+        size_t d = 0;
+        for (int i = 0; i < runs; i++) d += count[i];
+        return d;
+    }
+
+    bool push(uint8_t s) {
+        if (runs && sym[runs - 1] == s && count[runs - 1] < PDA_RUN_MAX) {
+            count[runs - 1]++;
+            return true;
+        }
+        if (runs == PDA_STACK_RUNS) return false;
+        sym[runs] = s;
+        count[runs++] = 1;
+        return true;
+    }
+
+    void pop() {
+        if (--count[runs - 1] == 0) runs--;
+    }
+};
+
+// Final word on a flow once its input ends.
+enum Verdict : uint8_t { VERDICT_SUCCESS, VERDICT_ALERT, VERDICT_WARN, VERDICT_OVERFLOW, VERDICT_COUNT };
+
+inline const char* verdictName(Verdict v) {
+    static const char* const NAMES[VERDICT_COUNT] = { "SUCCESS", "ALERT", "WARN", "OVERFLOW" };
+    return v < VERDICT_COUNT ? NAMES[v] : "?";
+}
+
+// One compiled table cell, 4 bytes.
+struct PdaTransition {
+    uint8_t next;   // next state
+    int8_t  delta;  // stack effect: +1 push, -1 pop, 0 none
+    uint8_t push;   // symbol pushed when delta > 0
+    uint8_t rule;   // which definition rule produced this cell
+};
+
+// === BUILT-IN PROTOCOL ===
+// Same text as PDACore/protocols/tcp_handshake.pda, embedded so every program
+// still runs when started outside the repo. Pass --pda <file> to override.
+const char* const TCP_HANDSHAKE_PDA = R"PDA(
+pda      tcp_handshake
+states   q0 q1 q2 qtrap
+start    q0
+accept   q2
+trap     qtrap
+inspect  q1
+inputs   SYN SYN_ACK ACK FIN RST DATA
+stack    Z0 SESSION TUNNEL
+bottom   Z0
+
+rule no_handshake: q0    *   *       -> qtrap
+rule handshake:    q0    SYN *       -> q1 push SESSION
+rule hijack:       q1    *   *       -> qtrap
+rule tunnel:       q1    *   SESSION -> q1
+rule close:        q1    FIN SESSION -> q2 pop
+rule reset:        q1    RST SESSION -> q2 pop
+rule tunnel:       q1    *   TUNNEL  -> q1
+rule nested_open:  q1    SYN SESSION -> q1 push TUNNEL
+rule nested_open:  q1    SYN TUNNEL  -> q1 push TUNNEL
+rule nested_close: q1    FIN TUNNEL  -> q1 pop
+rule nested_close: q1    RST TUNNEL  -> q1 pop
+rule after_close:  q2    *   *       -> qtrap
+rule teardown:     q2    ACK *       -> q2
+rule teardown:     q2    FIN *       -> q2
+rule teardown:     q2    RST *       -> q2
+rule blocked:      qtrap *   *       -> qtrap
+)PDA";
+
+class PdaTable {
+public:
+    std::string name;
+    std::vector<std::string> states;
+    std::vector<std::string> stackSyms;
+    std::vector<std::string> rules;
+    std::vector<bool> accepting;
+    std::vector<bool> inspecting;    // payloads accepted in these states go to the signature scan
+    std::vector<bool> handshaking;   // session opened but not yet established (short timeout)
+    uint8_t start = 0;
+    uint8_t trap = 0;
+    uint8_t bottom = 0;
+    uint8_t emptyTop = 0;           // extra stack-top column for an empty stack
+
+    // --- HOT PATH ---
+    void reset(PdaConfig& c) const {
+        c.state = start;
+        c.runs = 1;
+        c.overflow = 0;
+        c.sym[0] = bottom;
+        c.count[0] = 1;
+    }
+
+    uint8_t top(const PdaConfig& c) const { return c.runs ? c.sym[c.runs - 1] : emptyTop; }
+
+    const PdaTransition& at(uint8_t state, Symbol sym, uint8_t stackTop) const {
+        return cells[(size_t(state) * SYM_COUNT + sym) * topCount + stackTop];
+    }
+
+    // Apply a looked-up cell (shared with the batch steppers). compile() never
+    // emits a pop on an empty stack; a push that does not fit traps the flow.
+    void apply(PdaConfig& c, const PdaTransition& t) const {
+        c.state = t.next;
+        if (t.delta > 0) {
+            if (!c.push(t.push)) {
+                c.overflow = 1;
+                c.state = trap;
+            }
+        } else if (t.delta < 0) {
+            c.pop();
+        }
+    }
+
+    PdaTransition step(PdaConfig& c, Symbol sym) const {
+        PdaTransition t = at(c.state, sym, top(c));
+        apply(c, t);
+        return t;
+    }
+
+    // Run a pre-classified packet stream until it ends or hits the trap. The
+    // table pointer and strides are kept in locals so the stack writes (which
+    // may alias anything, being bytes) never force them to be reloaded.
+    size_t run(PdaConfig& c, const Symbol* syms, size_t n) const {
+        const PdaTransition* tab = cells.data();
+        const size_t tops = topCount;
+        const uint8_t trapState = trap;
+        uint8_t state = c.state;
+        uint8_t tp = top(c);    // top cached in a register
+        size_t i = 0;
+        while (i < n) {
+            PdaTransition t = tab[(size_t(state) * SYM_COUNT + syms[i++]) * tops + tp];
+            state = t.next;
+            if (t.delta > 0) {
+                if (!c.push(t.push)) {
+                    c.overflow = 1;
+                    state = trapState;
+                }
+                tp = t.push;
+            } else if (t.delta < 0) {
+                c.pop();
+                tp = top(c);
+            }
+            if (state == trapState) break;
+        }
+        c.state = state;
+        return i;
+    }
+
+    // Raw table for batch steppers: cell index = (state * SYM_COUNT + sym) * tops() + top
+    const PdaTransition* data() const { return cells.data(); }
+    size_t tops() const { return topCount; }
+
+    // --- LOOKUPS ---
+    bool isTrap(uint8_t state) const { return state == trap; }
+    bool isAccepting(uint8_t state) const { return accepting[state]; }
+    bool isInspected(uint8_t state) const { return inspecting[state]; }
+    bool isHandshake(uint8_t state) const { return handshaking[state]; }
+    Verdict verdict(const PdaConfig& c) const {
+        if (c.overflow) return VERDICT_OVERFLOW;
+        return isTrap(c.state) ? VERDICT_ALERT : isAccepting(c.state) ? VERDICT_SUCCESS : VERDICT_WARN;
+    }
+    const std::string& stackName(uint8_t sym) const {
+        static const std::string EMPTY = "EMPTY";
+        return sym < stackSyms.size() ? stackSyms[sym] : EMPTY;
+    }
+    int stateId(const std::string& n) const { return indexOf(states, n); }
+    int stackId(const std::string& n) const { return indexOf(stackSyms, n); }
+    int ruleId(const std::string& n) const { return indexOf(rules, n); }
+
+    // Map rule names to front-end text once; unknown rules keep their own name.
+    std::vector<std::string> ruleTexts(const std::vector<std::pair<std::string, std::string>>& text) const {
+        std::vector<std::string> out(rules);
+        for (const auto& kv : text) {
+            int id = ruleId(kv.first);
+            if (id >= 0) out[id] = kv.second;
+        }
+        return out;
+    }
+
+    // --- DEFINITION COMPILER ---
+    // Returns false and fills err (with the line number) on a malformed definition.
+    bool compile(const std::string& text, std::string& err);
+
+    bool loadFile(const std::string& path, std::string& err) {
+        std::ifstream f(path);
+        if (!f) { err = "Cannot open PDA definition: " + path; return false; }
+        std::stringstream ss;
+        ss << f.rdbuf();
+        return compile(ss.str(), err);
+    }
+
+    // Empty path = built-in definition (the TCP handshake unless told otherwise).
+    bool load(const std::string& path, std::string& err, const char* builtin = TCP_HANDSHAKE_PDA) {
+        return path.empty() ? compile(builtin, err) : loadFile(path, err);
+    }
+
+private:
+    std::vector<PdaTransition> cells;
+    size_t topCount = 0;
+
+    static int indexOf(const std::vector<std::string>& v, const std::string& n) {
+        for (size_t i = 0; i < v.size(); i++) if (v[i] == n) return int(i);
+        return -1;
+    }
+};
+
+// === DEFINITION FORMAT ===
+//   pda <name>                      states <s...>      start <s>     accept <s...>
+//   trap <s>                        inputs <SYM...>    stack <X...>  bottom <X>
+//   inspect <s...>                  handshake <s...>
+//   rule <name>: <state> <input|*> <top|*> -> <next> [push <X> | pop]
+// Inputs are names from the packet alphabet (pda_symbols.h); a bare name covers
+// both directions, "SYN>" / "SYN<" only the initiator's / responder's, and '*'
+// every declared input. '*' as the stack top also matches an empty stack.
+// Rules are applied in order and later rules overwrite the cells of earlier
+// ones; cells no rule covers go to the trap.
+inline bool PdaTable::compile(const std::string& text, std::string& err) {
+    struct RawRule { int line; std::string name, from, input, stackTop, to, op, pushSym; };
+    std::vector<RawRule> raw;
+    std::vector<std::string> acceptNames, inspectNames, handshakeNames, inputNames;
+    std::string startName, trapName, bottomName;
+
+    *this = PdaTable();
+    std::istringstream in(text);
+    std::string line;
+    int lineNo = 0;
+    auto fail = [&](int ln, const std::string& msg) {
+        err = "PDA definition line " + std::to_string(ln) + ": " + msg;
+        return false;
+    };
+
+    while (std::getline(in, line)) {
+        lineNo++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream ls(line);
+        std::vector<std::string> tok;
+        for (std::string t; ls >> t;) tok.push_back(t);
+        if (tok.empty()) continue;
+
+        const std::string& key = tok[0];
+        std::vector<std::string> args(tok.begin() + 1, tok.end());
+        if (key == "pda" && args.size() == 1)        name = args[0];
+        else if (key == "states")                    states = args;
+        else if (key == "start" && args.size() == 1) startName = args[0];
+        else if (key == "accept")                    acceptNames = args;
+        else if (key == "inspect")                   inspectNames = args;
+        else if (key == "handshake")                 handshakeNames = args;
+        else if (key == "trap" && args.size() == 1)  trapName = args[0];
+        else if (key == "inputs")                    inputNames = args;
+        else if (key == "stack")                     stackSyms = args;
+        else if (key == "bottom" && args.size() == 1) bottomName = args[0];
+        else if (key == "rule") {
+            // rule name: from input top -> to [push X | pop]
+            if (args.size() < 6 || args[0].back() != ':' || args[4] != "->")
+                return fail(lineNo, "expected 'rule <name>: <state> <input> <top> -> <next> [push X | pop]'");
+            RawRule r{ lineNo, args[0].substr(0, args[0].size() - 1), args[1], args[2], args[3], args[5], "", "" };
+            if (args.size() == 8 && args[6] == "push") { r.op = "push"; r.pushSym = args[7]; }
+            else if (args.size() == 7 && args[6] == "pop") r.op = "pop";
+            else if (args.size() != 6) return fail(lineNo, "stack action must be 'push <X>' or 'pop'");
+            raw.push_back(r);
+        }
+        else return fail(lineNo, "unknown or malformed directive '" + key + "'");
+    }
+
+    if (states.empty() || states.size() > 255) return fail(lineNo, "need 1..255 states");
+    if (stackSyms.empty() || stackSyms.size() > 254) return fail(lineNo, "need 1..254 stack symbols");
+    int s0 = stateId(startName), tr = stateId(trapName), z0 = stackId(bottomName);
+    if (s0 < 0) return fail(lineNo, "unknown start state '" + startName + "'");
+    if (tr < 0) return fail(lineNo, "unknown trap state '" + trapName + "'");
+    if (z0 < 0) return fail(lineNo, "unknown bottom symbol '" + bottomName + "'");
+    start = uint8_t(s0);
+    trap = uint8_t(tr);
+    bottom = uint8_t(z0);
+    emptyTop = uint8_t(stackSyms.size());
+    topCount = stackSyms.size() + 1;
+
+    accepting.assign(states.size(), false);
+    for (const std::string& a : acceptNames) {
+        int id = stateId(a);
+        if (id < 0) return fail(lineNo, "unknown accept state '" + a + "'");
+        accepting[id] = true;
+    }
+    inspecting.assign(states.size(), false);
+    for (const std::string& a : inspectNames) {
+        int id = stateId(a);
+        if (id < 0) return fail(lineNo, "unknown inspect state '" + a + "'");
+        inspecting[id] = true;
+    }
+    handshaking.assign(states.size(), false);
+    for (const std::string& a : handshakeNames) {
+        int id = stateId(a);
+        if (id < 0) return fail(lineNo, "unknown handshake state '" + a + "'");
+        handshaking[id] = true;
+    }
+
+    uint32_t declared = 0;
+    for (const std::string& s : inputNames) {
+        uint32_t ids = symbolMask(s);
+        if (!ids) return fail(lineNo, "'" + s + "' is not in the packet alphabet");
+        declared |= ids;
+    }
+
+    // Everything starts in the trap; rules then carve out the legal moves.
+    rules.push_back("reject");
+    cells.assign(states.size() * SYM_COUNT * topCount, PdaTransition{ trap, 0, 0, 0 });
+
+    for (const RawRule& r : raw) {
+        int from = stateId(r.from), to = stateId(r.to);
+        if (from < 0) return fail(r.line, "unknown state '" + r.from + "'");
+        if (to < 0) return fail(r.line, "unknown state '" + r.to + "'");
+        uint32_t syms = declared;
+        int tp = -1, push = 0;
+        if (r.input != "*") {
+            syms = symbolMask(r.input);
+            if (!syms || (syms & ~declared)) return fail(r.line, "input '" + r.input + "' not declared in 'inputs'");
+        }
+        if (r.stackTop != "*" && (tp = stackId(r.stackTop)) < 0)
+            return fail(r.line, "unknown stack symbol '" + r.stackTop + "'");
+        if (r.op == "push" && (push = stackId(r.pushSym)) < 0)
+            return fail(r.line, "unknown stack symbol '" + r.pushSym + "'");
+        if (r.op == "pop" && tp < 0)
+            return fail(r.line, "'pop' needs an explicit stack top, not '*'");
+
+        int ruleIdx = ruleId(r.name);
+        if (ruleIdx < 0) {
+            if (rules.size() == 255) return fail(r.line, "too many rules");
+            ruleIdx = int(rules.size());
+            rules.push_back(r.name);
+        }
+
+        PdaTransition t{ uint8_t(to), int8_t(r.op == "push" ? 1 : r.op == "pop" ? -1 : 0), uint8_t(push), uint8_t(ruleIdx) };
+        for (int s = 0; s < SYM_COUNT; s++) {
+            if (!(syms >> s & 1)) continue;
+            for (size_t k = 0; k < topCount; k++) {
+                if (tp >= 0 && int(k) != tp) continue;
+                cells[(size_t(from) * SYM_COUNT + s) * topCount + k] = t;
+            }
+        }
+    }
+    return true;
+}
+
+// Shared "--pda <file>" handling for the front ends' main().
+inline std::string pdaPathFromArgs(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::string(argv[i]) == "--pda") return argv[i + 1];
+    return "";
+}
@@ -0,0 +1,636 @@
+#pragma once
+// === MULTI-FLOW SESSION TABLE ===
+// Per-flow PDA configurations for millions of concurrent conversations, keyed
+// by the TCP/UDP 5-tuple. Open addressing with linear probing over a flat array
+// of 64-byte slots: one lookup touches one cache line in the common case, and
+// a flow costs exactly one slot (key + hash + state byte + inline run-length
+// stack + signature scan state + timer handle).
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include "pda_admission.h"
+#include "pda_engine.h"
+#include "pda_metrics.h"
+#include "pda_regex.h"
+#include "pda_spans.h"
+#include "pda_tcp.h"
+#include "pda_timers.h"
+
+// === FLOW KEY ===
+// IPv4 addresses are stored as v4-mapped IPv6 (::ffff:a.b.c.d) so one key type
+// covers both families. Ports and addresses are kept in host byte order.
+struct FlowKey {
+    uint32_t src[4];
+    uint32_t dst[4];
+    uint16_t sport;
+    uint16_t dport;
+    uint8_t  proto;
+    uint8_t  pad[3];
+
+    static FlowKey ipv4(uint32_t srcIp, uint32_t dstIp, uint16_t srcPort, uint16_t dstPort, uint8_t protocol = 6) {
+        FlowKey k{};
+        k.src[2] = k.dst[2] = 0x0000FFFF;
+        k.src[3] = srcIp;
+        k.dst[3] = dstIp;
+        k.sport = srcPort;
+        k.dport = dstPort;
+        k.proto = protocol;
+        return k;
+    }
+
+    // Addresses as the 16 raw (network order) bytes from the IPv6 header.
+    static FlowKey ipv6(const uint8_t* srcIp, const uint8_t* dstIp, uint16_t srcPort, uint16_t dstPort, uint8_t protocol = 6) {
+        FlowKey k{};
+        for (int i = 0; i < 4; i++) {
+            const uint8_t* s = srcIp + 4 * i;
+            const uint8_t* d = dstIp + 4 * i;
+            k.src[i] = (uint32_t(s[0]) << 24) | (uint32_t(s[1]) << 16) | (uint32_t(s[2]) << 8) | s[3];
+            k.dst[i] = (uint32_t(d[0]) << 24) | (uint32_t(d[1]) << 16) | (uint32_t(d[2]) << 8) | d[3];
+        }
+        k.sport = srcPort;
+        k.dport = dstPort;
+        k.proto = protocol;
+        return k;
+    }
+
+    bool isIpv4() const { return src[0] == 0 && src[1] == 0 && src[2] == 0x0000FFFF && dst[2] == 0x0000FFFF; }
+
+    // Both directions of a conversation must hit the same slot: order the two
+    // endpoints and report whether they were swapped (i.e. the packet direction).
+    bool canonicalize() {
+        int c = std::memcmp(src, dst, sizeof(src));
+        if (c < 0 || (c == 0 && sport <= dport)) return false;
+        uint32_t tmp[4];
+        std::memcpy(tmp, src, sizeof(src));
+        std::memcpy(src, dst, sizeof(src));
+        std::memcpy(dst, tmp, sizeof(src));
+        uint16_t p = sport; sport = dport; dport = p;
+        return true;
+    }
+
+    bool operator==(const FlowKey& o) const { return std::memcmp(this, &o, sizeof(FlowKey)) == 0; }
+};
+static_assert(sizeof(FlowKey) == 40, "FlowKey must stay packed (hashed and compared as raw bytes)");
+
+// Multiply-rotate over the five key words plus a final avalanche. The table
+// uses the low 32 bits, which are never 0 (0 marks an empty slot).
+inline uint64_t hashFlowKey64(const FlowKey& k) {
+    uint64_t w[5];
+    std::memcpy(w, &k, sizeof(w));
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+    for (uint64_t x : w) {
+        h ^= x * 0xC2B2AE3D27D4EB4FULL;
+        h = (h << 31) | (h >> 33);
+        h *= 0x9E3779B97F4A7C15ULL;
+    }
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+inline uint32_t hashFlowKey(const FlowKey& k) {
+    uint32_t r = uint32_t(hashFlowKey64(k));
+    return r ? r : 1;
+}
+
+// === FLOW TABLE ===
+// Set in FlowSlot::scan once a payload signature fired; the low bits then hold
+// the signature index instead of a DFA state.
+constexpr uint16_t SCAN_HIT = 0x8000;
+
+struct alignas(64) FlowSlot {
+    FlowKey   key;      // 40
+    PdaConfig pda;      // 13
+    uint8_t   origin;   // 1, FlowKey::canonicalize() result of the flow's first packet
+    uint16_t  scan;     // 2, signature DFA state carried across packets
+    uint32_t  hash;     // 4, 0 = empty
+    uint32_t  timer;    // 4, TimerWheel handle while timeouts are on
+};
+static_assert(sizeof(FlowSlot) == 64, "a flow must fit in one cache line");
+
+class FlowTable {
+public:
+    explicit FlowTable(size_t expectedFlows = 1024) {
+        size_t cap = 16;
+        while (cap * 3 < expectedFlows * 4) cap <<= 1;   // start below 75% load
+        slots.assign(cap, FlowSlot{});
+        mask = cap - 1;
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    size_t memoryBytes() const { return slots.size() * sizeof(FlowSlot); }
+
+    FlowSlot* find(const FlowKey& key) { return find(key, hashFlowKey(key)); }
+
+    // Pull a flow's home slot towards L1 ahead of the lookup.
+    void prefetch(uint32_t h) const {
+#if defined(__GNUC__)
+        __builtin_prefetch(&slots[h & mask], 1);
+#else
+        (void)h;
+#endif
+    }
+
+    FlowSlot* find(const FlowKey& key, uint32_t h) {
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            FlowSlot& s = slots[i];
+            if (s.hash == 0) return nullptr;
+            if (s.hash == h && s.key == key) return &s;
+        }
+    }
+
+    // Returns the flow's slot; a new slot has hash set and pda/scan/timer zeroed,
+    // and the caller is expected to initialise its configuration.
+    FlowSlot* findOrInsert(const FlowKey& key, uint32_t h, bool& inserted) {
+        if ((count + 1) * 4 > slots.size() * 3) grow();
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            FlowSlot& s = slots[i];
+            if (s.hash == 0) {
+                s.key = key;
+                s.hash = h;
+                count++;
+                inserted = true;
+                return &s;
+            }
+            if (s.hash == h && s.key == key) {
+                inserted = false;
+                return &s;
+            }
+        }
+    }
+
+    // Backward-shift deletion: no tombstones, probe chains stay short forever.
+    bool erase(const FlowKey& key) {
+        FlowSlot* s = find(key);
+        if (!s) return false;
+        eraseSlot(size_t(s - slots.data()));
+        return true;
+    }
+
+    void erase(FlowSlot* s) { eraseSlot(size_t(s - slots.data())); }
+
+    // The flow with this hash that owns timer t. Slots move on erase and grow,
+    // so the wheel keeps the hash and finds the slot again when it fires.
+    FlowSlot* findTimer(uint32_t h, uint32_t t) {
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            FlowSlot& s = slots[i];
+            if (s.hash == 0) return nullptr;
+            if (s.hash == h && s.timer == t) return &s;
+        }
+    }
+
+    void eraseSlot(size_t i) {
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask;; j = (j + 1) & mask) {
+            FlowSlot& s = slots[j];
+            if (s.hash == 0) break;
+            size_t home = s.hash & mask;
+            // Move s into the hole if its home is not cyclically in (hole, j]
+            bool stays = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+            if (!stays) {
+                slots[hole] = s;
+                hole = j;
+            }
+        }
+        slots[hole] = FlowSlot{};
+        count--;
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) {
+        for (FlowSlot& s : slots)
+            if (s.hash) fn(s);
+    }
+
+private:
+    std::vector<FlowSlot> slots;
+    size_t mask = 0;
+    size_t count = 0;
+
+    void grow() {
+        std::vector<FlowSlot> old;
+        old.swap(slots);
+        slots.assign(old.size() * 2, FlowSlot{});
+        mask = slots.size() - 1;
+        for (const FlowSlot& s : old) {
+            if (!s.hash) continue;
+            size_t i = s.hash & mask;
+            while (slots[i].hash) i = (i + 1) & mask;
+            slots[i] = s;
+        }
+    }
+};
+
+// === FLOW TIMEOUTS ===
+// A live table cannot wait for the end of the stream: flows that go quiet are
+// evicted with the verdict they have reached (WARN for an unfinished session).
+// Half-open flows (states listed in 'handshake') get a short timeout so a SYN
+// flood cannot grow the table; finished and trapped flows linger a little for
+// late teardown packets, which are still judged against the closed session.
+// A zero timeout leaves the flow unarmed in those states (a flow entering one
+// has its timer cancelled); all zero = never evict. The wheel ticks every
+// 2^20 ns (~1.05 ms).
+struct FlowTimeouts {
+    uint64_t handshakeNanos = 0;
+    uint64_t idleNanos = 0;
+    uint64_t lingerNanos = 0;
+    bool enabled() const { return handshakeNanos || idleNanos || lingerNanos; }
+};
+
+constexpr int FLOW_TICK_SHIFT = 20;
+
+// What a flow did as it fell into the trap, for the alert hook. tsNanos is the
+// packet time of the last advance() (0 when the clock is not driven).
+struct FlowAlert {
+    uint64_t tsNanos;
+    uint8_t  from;        // state before the packet
+    Symbol   sym;
+    uint8_t  rule;
+    int16_t  signature;   // payload signature that fired, -1 = protocol violation
+    bool     overflow;    // nesting exceeded the inline stack
+};
+
+// === FLOW VALIDATOR ===
+// One pass over an interleaved packet stream: every packet steps its own flow's
+// PDA. Alerts are counted the moment a flow falls into the trap; the remaining
+// verdicts (SUCCESS / WARN) are settled when a flow times out or by finish()
+// when the stream ends.
+struct FlowStats {
+    uint64_t packets = 0;        // inputs stepped (a FIN carrying data is two, see tcpSplitFin)
+    uint64_t flows = 0;
+    uint64_t alerts = 0;         // flows that entered the trap (overflows included)
+    uint64_t blocked = 0;        // packets that arrived on an already trapped flow
+    uint64_t signatures = 0;     // of the alerts, flows stopped by a payload signature
+    uint64_t expired = 0;        // flows evicted by a timeout (their verdicts are in verdicts[])
+    uint64_t peakFlows = 0;      // most flows in the table at once
+    uint64_t halfOpen = 0;       // flows admitted to the half-open filter
+    uint64_t promoted = 0;       // ... of which got past the handshake into the table
+    uint64_t verdicts[VERDICT_COUNT] = {};
+};
+
+class FlowValidator {
+public:
+    // With signatures, payloads accepted in an 'inspect' state are scanned too,
+    // and a hit sends the flow to the trap like any protocol violation.
+    FlowValidator(const PdaTable& protocol, size_t expectedFlows = 1024, const SignatureSet* signatures = nullptr)
+        : protocol(protocol), table(expectedFlows), signatures(signatures) {}
+
+    // Returns true when this packet pushed its flow into the trap.
+    bool onPacket(const FlowKey& key, Symbol sym) { return onPacket(key, hashFlowKey(key), sym); }
+
+    bool onPacket(const FlowKey& key, uint32_t h, Symbol sym, const uint8_t* payload = nullptr, size_t payloadLen = 0) {
+        if (!spans) return packet(key, h, sym, payload, payloadLen);
+        size_t mark = spans->mark();
+        uint64_t t0 = readTsc();
+        bool raised = packet(key, h, sym, payload, payloadLen);
+        spans->top(SPAN_PACKET, t0, readTsc(), mark);
+        return raised;
+    }
+
+    // A captured segment: canonical key, whether canonicalize() swapped it, the
+    // raw TCP flags and whether it carries data. The first packet of a flow
+    // fixes its initiator; the input symbol then comes from tcpInput() with the
+    // direction relative to it. hasPayload comes from the IP length, not from
+    // payloadLen: a snaplen-limited capture keeps fewer bytes than were sent,
+    // and those bytes are only used for the signature scan.
+    bool onSegment(const FlowKey& key, uint32_t h, bool reversed, uint8_t tcpFlags, bool hasPayload = false,
+                   const uint8_t* payload = nullptr, size_t payloadLen = 0) {
+        if (!spans) return segment(key, h, reversed, tcpFlags, hasPayload, payload, payloadLen);
+        size_t mark = spans->mark();
+        uint64_t t0 = readTsc();
+        bool raised = segment(key, h, reversed, tcpFlags, hasPayload, payload, payloadLen);
+        spans->top(SPAN_PACKET, t0, readTsc(), mark);
+        return raised;
+    }
+
+    // Batched form for large tables: hash a window of packets and prefetch their
+    // slots first, so the cache misses of the whole window overlap instead of
+    // being paid one after another. Returns the number of new alerts.
+    size_t onBatch(const FlowKey* keys, const Symbol* syms, size_t n) {
+        const size_t WINDOW = 16;
+        uint32_t hashes[WINDOW];
+        size_t raised = 0;
+        for (size_t base = 0; base < n; base += WINDOW) {
+            size_t m = (n - base < WINDOW) ? n - base : WINDOW;
+            for (size_t i = 0; i < m; i++) {
+                hashes[i] = hashFlowKey(keys[base + i]);
+                table.prefetch(hashes[i]);
+            }
+            for (size_t i = 0; i < m; i++)
+                raised += onPacket(keys[base + i], hashes[i], syms[base + i]);
+        }
+        return raised;
+    }
+
+    // Turn on eviction (before the first packet). The clock is driven by advance().
+    void setTimeouts(const FlowTimeouts& t) {
+        timed = t.enabled();
+        auto ticks = [](uint64_t ns) { return ns ? ((ns - 1) >> FLOW_TICK_SHIFT) + 1 : 0; };
+        timeouts.assign(protocol.states.size(), ticks(t.idleNanos));
+        rotateTicks = ticks(t.handshakeNanos);
+        for (size_t i = 0; i < timeouts.size(); i++) {
+            if (protocol.isHandshake(uint8_t(i))) timeouts[i] = ticks(t.handshakeNanos);
+            if (protocol.isAccepting(uint8_t(i)) || protocol.isTrap(uint8_t(i))) timeouts[i] = ticks(t.lingerNanos);
+        }
+    }
+
+    // Keep flows in a handshake state in a HalfOpenFilter of about `capacity`
+    // flows per generation instead of the table (before the first packet).
+    // With timeouts, its generations rotate once per handshake timeout.
+    void setHalfOpenFilter(size_t capacity) { halfOpen = HalfOpenFilter(capacity); }
+
+    // Tracing: fn(const FlowSlot&, Symbol, const PdaTransition&, bool blocked)
+    // after every packet stepped in the table. Flows parked in the half-open
+    // filter step outside it, so tracing goes with the filter off.
+    void setStepHook(std::function<void(const FlowSlot&, Symbol, const PdaTransition&, bool)> fn) { stepHook = std::move(fn); }
+
+    // Alerts: fn(const FlowSlot&, const FlowAlert&) the moment a flow enters the
+    // trap, on the validating thread. Meant for a non-blocking sink (AlertSink).
+    void setAlertHook(std::function<void(const FlowSlot&, const FlowAlert&)> fn) { alertHook = std::move(fn); }
+
+    // Count every packet's (state, symbol) transition, alerts and settled
+    // verdicts into m, and time each packet's step (two clock reads per packet).
+    // m belongs to this validator's thread; nullptr = off.
+    void setMetrics(FlowMetrics* m) { metrics = m; }
+
+    // Record every packet's stages (lookup, classify, transition, signature,
+    // emit) under one "packet" span into r, this validator's thread's ring.
+    void setSpans(SpanRing* r) { spans = r; }
+
+    // Move the clock to a packet's timestamp, evicting every flow whose timeout
+    // passed: fn(const FlowSlot&, Verdict) sees it just before it is erased.
+    // Half-open flows aged out of the filter are counted but have no slot.
+    template <typename Fn>
+    void advance(uint64_t tsNanos, Fn&& fn) {
+        clock = tsNanos;
+        uint64_t to = tsNanos >> FLOW_TICK_SHIFT;
+        if (to <= wheel.now()) return;
+        wheel.advance(to, [&](uint32_t id, uint32_t h) {
+            FlowSlot* s = table.findTimer(h, id);
+            Verdict v = protocol.verdict(s->pda);
+            expiredVerdicts[v]++;
+            stats.expired++;
+            if (metrics) metrics->onVerdict(v);
+            fn(*s, v);
+            table.erase(s);
+        });
+        if (halfOpen.enabled() && rotateTicks && wheel.now() - lastRotation >= rotateTicks) {
+            halfOpen.rotate([&](uint8_t tag) { dropParked(tag); });
+            lastRotation = wheel.now();
+        }
+    }
+
+    void advance(uint64_t tsNanos) { advance(tsNanos, [](const FlowSlot&, Verdict) {}); }
+
+    // End of stream: hand every flow still in the table and its verdict to
+    // fn(const FlowSlot&, Verdict). Verdicts of evicted flows are already counted.
+    template <typename Fn>
+    void finish(Fn&& fn) {
+        for (int v = 0; v < VERDICT_COUNT; v++) stats.verdicts[v] = expiredVerdicts[v];
+        halfOpen.forEach([&](uint8_t tag) {
+            Verdict v = protocol.verdict(parked[tag & PARKED_MASK]);
+            stats.verdicts[v]++;
+            if (metrics) metrics->onVerdict(v);
+        });
+        table.forEach([&](FlowSlot& s) {
+            Verdict v = protocol.verdict(s.pda);
+            stats.verdicts[v]++;
+            if (metrics) metrics->onVerdict(v);
+            fn(s, v);
+        });
+    }
+
+    const FlowStats& getStats() const { return stats; }
+    FlowTable& flows() { return table; }
+    const FlowTable& flows() const { return table; }
+    const TimerWheel& timers() const { return wheel; }
+    const HalfOpenFilter& halfOpenFilter() const { return halfOpen; }
+
+private:
+    // --- STAGE SPANS --- one null test each when tracing is off
+    uint64_t spanStart() const { return spans ? readTsc() : 0; }
+    void spanEnd(SpanStage stage, uint64_t t0, uint8_t depth) {
+        if (spans) spans->add(stage, t0, readTsc(), depth);
+    }
+
+    bool packet(const FlowKey& key, uint32_t h, Symbol sym, const uint8_t* payload, size_t payloadLen) {
+        uint64_t t0 = spanStart();
+        if (halfOpen.enabled()) {
+            FlowSlot* s = table.find(key, h);
+            spanEnd(SPAN_LOOKUP, t0, 1);
+            if (!s) return admit(key, h, false, sym, sym, payloadLen != 0, payload, payloadLen);
+            return step(s, sym, payload, payloadLen);
+        }
+        FlowSlot* s = slotFor(key, h, false);
+        spanEnd(SPAN_LOOKUP, t0, 1);
+        return step(s, sym, payload, payloadLen);
+    }
+
+    bool segment(const FlowKey& key, uint32_t h, bool reversed, uint8_t tcpFlags, bool hasPayload,
+                 const uint8_t* payload, size_t payloadLen) {
+        uint64_t t0 = spanStart();
+        if (halfOpen.enabled()) {
+            FlowSlot* s = table.find(key, h);
+            spanEnd(SPAN_LOOKUP, t0, 1);
+            t0 = spanStart();
+            if (!s) {
+                Symbol fromInitiator = tcpInput(tcpFlags, hasPayload, false);
+                Symbol fromResponder = tcpInput(tcpFlags, hasPayload, true);
+                spanEnd(SPAN_CLASSIFY, t0, 1);
+                return admit(key, h, reversed, fromInitiator, fromResponder, hasPayload, payload, payloadLen);
+            }
+            Symbol sym = tcpInput(tcpFlags, hasPayload, reversed != bool(s->origin));
+            spanEnd(SPAN_CLASSIFY, t0, 1);
+            return stepSegment(s, sym, hasPayload, payload, payloadLen);
+        }
+        FlowSlot* s = slotFor(key, h, reversed);
+        spanEnd(SPAN_LOOKUP, t0, 1);
+        t0 = spanStart();
+        Symbol sym = tcpInput(tcpFlags, hasPayload, reversed != bool(s->origin));
+        spanEnd(SPAN_CLASSIFY, t0, 1);
+        return stepSegment(s, sym, hasPayload, payload, payloadLen);
+    }
+
+    // A FIN carrying data steps its data (scanned like any payload) first; the
+    // FIN follows unless the data already trapped the flow.
+    bool stepSegment(FlowSlot* s, Symbol sym, bool hasPayload, const uint8_t* payload, size_t payloadLen) {
+        Symbol data;
+        if (!tcpSplitFin(sym, hasPayload, data)) return step(s, sym, payload, payloadLen);
+        bool raised = step(s, data, payload, payloadLen);
+        if (protocol.isTrap(s->pda.state)) return raised;
+        return step(s, sym, nullptr, 0);
+    }
+
+    // A new slot starts in the start state, or where a flow promoted out of the
+    // half-open filter got to (that flow was counted when it was admitted).
+    FlowSlot* slotFor(const FlowKey& key, uint32_t h, bool reversed, const PdaConfig* from = nullptr) {
+        bool inserted;
+        FlowSlot* s = table.findOrInsert(key, h, inserted);
+        if (inserted) {
+            if (from) s->pda = *from;
+            else protocol.reset(s->pda);
+            s->origin = reversed;
+            s->timer = TimerWheel::NIL;
+            stats.flows += !from;
+            if (table.size() > stats.peakFlows) stats.peakFlows = table.size();
+        }
+        return s;
+    }
+
+    // --- HALF-OPEN ADMISSION ---
+    // A packet of a flow the table does not hold. If the flow (new, or parked in
+    // the filter) stays in a handshake state, it is (re)parked with the index of
+    // its configuration in `parked` and its origin bit as the tag. Otherwise it
+    // gets its slot and the packet is stepped there as usual. Data segments
+    // always promote, so the signature scan sees every byte.
+    bool admit(const FlowKey& key, uint32_t h, bool reversed, Symbol fromInitiator, Symbol fromResponder,
+               bool hasPayload, const uint8_t* payload, size_t payloadLen) {
+        uint64_t t0 = metrics ? monotonicNanos() : 0;
+        uint64_t h64 = hashFlowKey64(key);
+        uint8_t tag;
+        bool known = halfOpen.take(h64, tag);
+        PdaConfig at{};
+        bool origin = reversed;
+        if (known) {
+            at = parked[tag & PARKED_MASK];
+            origin = tag & PARKED_ORIGIN;
+        } else {
+            protocol.reset(at);
+        }
+        Symbol sym = reversed != origin ? fromResponder : fromInitiator;
+        if (!hasPayload) {
+            PdaConfig next = at;
+            uint64_t span = spanStart();
+            protocol.step(next, sym);
+            spanEnd(SPAN_TRANSITION, span, 1);
+            int idx = protocol.isHandshake(next.state) ? parkedIndex(next) : -1;
+            if (idx >= 0) {
+                stats.packets++;
+                if (!known) {
+                    stats.flows++;
+                    stats.halfOpen++;
+                }
+                halfOpen.put(h64, uint8_t(idx | (origin ? PARKED_ORIGIN : 0)), [&](uint8_t t) { dropParked(t); });
+                if (metrics) metrics->onStep(at.state, sym, monotonicNanos() - t0);
+                return false;
+            }
+        }
+        if (known) stats.promoted++;
+        return stepSegment(slotFor(key, h, origin, known ? &at : nullptr), sym, hasPayload, payload, payloadLen);
+    }
+
+    // Handshake configurations seen so far, up to PARKED_MASK of them; -1 = no room.
+    int parkedIndex(const PdaConfig& c) {
+        for (size_t i = 0; i < parked.size(); i++) {
+            const PdaConfig& p = parked[i];
+            bool same = p.state == c.state && p.runs == c.runs && p.overflow == c.overflow;
+            for (int r = 0; same && r < c.runs; r++) same = p.sym[r] == c.sym[r] && p.count[r] == c.count[r];
+            if (same) return int(i);
+        }
+        if (parked.size() > PARKED_MASK) return -1;
+        parked.push_back(c);
+        return int(parked.size() - 1);
+    }
+
+    void dropParked(uint8_t tag) {
+        Verdict v = protocol.verdict(parked[tag & PARKED_MASK]);
+        expiredVerdicts[v]++;
+        stats.expired++;
+        if (metrics) metrics->onVerdict(v);
+    }
+
+    // Every packet, blocked ones included, restarts its flow's timeout for the
+    // state it left the flow in, or disarms it when that state has none.
+    bool step(FlowSlot* s, Symbol sym, const uint8_t* payload, size_t payloadLen) {
+        uint64_t t0 = 0;
+        uint8_t from = s->pda.state;
+        if (metrics) t0 = monotonicNanos();
+        uint64_t span = spanStart();
+        bool raised = transition(s, sym, payload, payloadLen);
+        spanEnd(SPAN_TRANSITION, span, 1);
+        if (stepHook) {
+            span = spanStart();
+            stepHook(*s, sym, last, lastBlocked);
+            spanEnd(SPAN_EMIT, span, 1);
+        }
+        if (timed) {
+            uint64_t after = timeouts[s->pda.state];
+            if (after == 0) {
+                if (s->timer != TimerWheel::NIL) wheel.cancel(s->timer);
+                s->timer = TimerWheel::NIL;
+            } else if (s->timer == TimerWheel::NIL) {
+                s->timer = wheel.add(wheel.now() + after, s->hash);
+            } else {
+                wheel.touch(s->timer, wheel.now() + after);
+            }
+        }
+        if (metrics) {
+            if (raised) metrics->onAlert();
+            metrics->onStep(from, sym, monotonicNanos() - t0);
+        }
+        return raised;
+    }
+
+    bool transition(FlowSlot* s, Symbol sym, const uint8_t* payload, size_t payloadLen) {
+        stats.packets++;
+        lastBlocked = protocol.isTrap(s->pda.state);
+        if (lastBlocked) {
+            stats.blocked++;
+            if (stepHook) last = protocol.at(s->pda.state, sym, protocol.top(s->pda));
+            return false;
+        }
+        uint8_t from = s->pda.state;
+        last = protocol.step(s->pda, sym);
+        if (protocol.isTrap(s->pda.state)) {
+            stats.alerts++;
+            if (alertHook) emitAlert(*s, FlowAlert{ clock, from, sym, last.rule, -1, s->pda.overflow != 0 });
+            return true;
+        }
+        if (payloadLen && signatures && protocol.isInspected(s->pda.state)) {
+            uint64_t t0 = spanStart();
+            int hit = signatures->inspect(s->scan, payload, payloadLen);
+            spanEnd(SPAN_SIGNATURE, t0, 2);
+            if (hit >= 0) {
+                s->scan = uint16_t(SCAN_HIT | hit);
+                s->pda.state = protocol.trap;
+                stats.signatures++;
+                stats.alerts++;
+                if (alertHook) emitAlert(*s, FlowAlert{ clock, from, sym, last.rule, int16_t(hit), false });
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void emitAlert(const FlowSlot& s, const FlowAlert& a) {
+        uint64_t t0 = spanStart();
+        alertHook(s, a);
+        spanEnd(SPAN_EMIT, t0, 2);
+    }
+
+    const PdaTable& protocol;
+    FlowTable table;
+    const SignatureSet* signatures;
+    FlowStats stats;
+    bool timed = false;
+    uint64_t rotateTicks = 0;         // half-open filter generation, 0 = rotate on load only
+    uint64_t lastRotation = 0;
+    HalfOpenFilter halfOpen;
+    static constexpr uint8_t PARKED_ORIGIN = 0x80;
+    static constexpr uint8_t PARKED_MASK = 0x7F;
+    std::vector<PdaConfig> parked;
+    std::vector<uint64_t> timeouts;   // per state, in wheel ticks, 0 = never
+    TimerWheel wheel;
+    uint64_t expiredVerdicts[VERDICT_COUNT] = {};
+    std::function<void(const FlowSlot&, Symbol, const PdaTransition&, bool)> stepHook;
+    PdaTransition last{};             // the packet just stepped, for the hook
+    bool lastBlocked = false;
+    std::function<void(const FlowSlot&, const FlowAlert&)> alertHook;
+    uint64_t clock = 0;               // packet time of the last advance()
+    FlowMetrics* metrics = nullptr;
+    SpanRing* spans = nullptr;
+};
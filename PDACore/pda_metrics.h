@@ -0,0 +1,365 @@
+#pragma once
+// === RUNTIME METRICS ===
+// Counters and step latencies of the validators, in Prometheus text format.
+// Every validating thread owns one FlowMetrics block: packets per (state,
+// input symbol) transition, alerts, settled verdicts, and an HDR-style
+// histogram of the time one packet takes to step. The owner bumps its own
+// counters with plain relaxed load + store (no locked instruction, no shared
+// cache line); an exporter thread may read them at any time and sums the
+// blocks when it renders, so the hot path never waits on anyone.
+//
+// The histogram is log-linear like HdrHistogram: values below 64 ns are exact,
+// above that every power of two is split into 32 sub-buckets, so any recorded
+// value is within ~3% of its bucket's bounds, up to 2^36 ns (~69 s).
+//
+// MetricsExporter serves the text on a local HTTP port, rewrites a file every
+// few seconds (write + rename, so a reader never sees half a file), or both.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pda_engine.h"
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+inline uint64_t monotonicNanos() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Single-writer counter: only the owning thread adds, anyone may read.
+inline void bump(std::atomic<uint64_t>& c, uint64_t n = 1) {
+    c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// === LATENCY HISTOGRAM ===
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int MAX_BITS = 36;
+    static constexpr int BUCKETS = (MAX_BITS - SUB_BITS) * (1 << SUB_BITS) + (2 << SUB_BITS);
+
+    LatencyHistogram() {
+        for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+    }
+
+    static int bucketOf(uint64_t ns) {
+        if (ns >> MAX_BITS) ns = (uint64_t(1) << MAX_BITS) - 1;
+        int msb = 63 - __builtin_clzll(ns | 1);
+        int shift = msb < SUB_BITS ? 0 : msb - SUB_BITS;
+        return (shift << SUB_BITS) + int(ns >> shift);
+    }
+
+    // Largest value that lands in bucket b.
+    static uint64_t upperBound(int b) {
+        int shift = b < (2 << SUB_BITS) ? 0 : (b >> SUB_BITS) - 1;
+        uint64_t mantissa = uint64_t(b - (shift << SUB_BITS));
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    void record(uint64_t ns) {
+        bump(counts[bucketOf(ns)]);
+        bump(total);
+        bump(sum, ns);
+    }
+
+    // Reader side: add this histogram into plain arrays.
+    void addTo(std::vector<uint64_t>& into, uint64_t& n, uint64_t& s) const {
+        into.resize(BUCKETS);
+        for (int b = 0; b < BUCKETS; b++) into[size_t(b)] += counts[b].load(std::memory_order_relaxed);
+        n += total.load(std::memory_order_relaxed);
+        s += sum.load(std::memory_order_relaxed);
+    }
+
+    // Smallest bucket bound covering a fraction q of the values in `buckets`.
+    static uint64_t quantile(const std::vector<uint64_t>& buckets, double q) {
+        uint64_t n = 0;
+        for (uint64_t c : buckets) n += c;
+        if (n == 0) return 0;
+        uint64_t want = uint64_t(q * double(n));
+        if (want == 0) want = 1;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets.size(); b++) {
+            seen += buckets[b];
+            if (seen >= want) return upperBound(int(b));
+        }
+        return upperBound(BUCKETS - 1);
+    }
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS];
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+};
+
+// === PER-THREAD COUNTERS ===
+class alignas(64) FlowMetrics {
+public:
+    FlowMetrics(size_t states) : states(states), transitions(new std::atomic<uint64_t>[states * SYM_COUNT]) {
+        for (size_t i = 0; i < states * SYM_COUNT; i++) transitions[i].store(0, std::memory_order_relaxed);
+        for (auto& v : verdicts) v.store(0, std::memory_order_relaxed);
+    }
+
+    // --- HOT PATH --- the owning thread only
+    void onStep(uint8_t from, Symbol sym, uint64_t ns) {
+        bump(transitions[size_t(from) * SYM_COUNT + sym]);
+        bump(packets);
+        latency.record(ns);
+    }
+
+    void onAlert() { bump(alerts); }
+    void onVerdict(Verdict v) { bump(verdicts[v]); }
+
+    // --- READERS ---
+    size_t stateCount() const { return states; }
+    uint64_t transitionCount(uint8_t from, Symbol sym) const {
+        return transitions[size_t(from) * SYM_COUNT + sym].load(std::memory_order_relaxed);
+    }
+    uint64_t packetCount() const { return packets.load(std::memory_order_relaxed); }
+    uint64_t alertCount() const { return alerts.load(std::memory_order_relaxed); }
+    uint64_t verdictCount(Verdict v) const { return verdicts[v].load(std::memory_order_relaxed); }
+    const LatencyHistogram& stepLatency() const { return latency; }
+
+private:
+    size_t states;
+    std::unique_ptr<std::atomic<uint64_t>[]> transitions;   // [state][symbol]
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> alerts{0};
+    std::atomic<uint64_t> verdicts[VERDICT_COUNT];
+    LatencyHistogram latency;
+};
+
+// === REGISTRY ===
+// One FlowMetrics per validating thread, added before the threads start.
+class MetricsRegistry {
+public:
+    explicit MetricsRegistry(const PdaTable& protocol) : protocol(protocol) {}
+
+    FlowMetrics* add() {
+        blocks.emplace_back(new FlowMetrics(protocol.states.size()));
+        return blocks.back().get();
+    }
+
+    size_t size() const { return blocks.size(); }
+
+    // Step latency over all threads at quantile q, in ns (bucket upper bound).
+    uint64_t latencyQuantile(double q) const {
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0, sumNs = 0;
+        mergeLatency(buckets, count, sumNs);
+        return LatencyHistogram::quantile(buckets, q);
+    }
+
+    std::string prometheus() const {
+        std::string o;
+        auto line = [&o](const std::string& name, const std::string& labels, uint64_t v) {
+            o += name;
+            if (!labels.empty()) o += "{" + labels + "}";
+            o += " " + std::to_string(v) + "\n";
+        };
+        auto head = [&o](const char* name, const char* type, const char* help) {
+            o += std::string("# HELP ") + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+        };
+        auto label = [](const char* key, const std::string& v) {
+            std::string s = std::string(key) + "=\"";
+            for (char c : v) {
+                if (c == '"' || c == '\\') s += '\\';
+                s += c;
+            }
+            return s + "\"";
+        };
+
+        head("pda_packets_total", "counter", "Packets stepped, by validating thread.");
+        for (size_t w = 0; w < blocks.size(); w++) line("pda_packets_total", label("worker", std::to_string(w)), blocks[w]->packetCount());
+
+        head("pda_transitions_total", "counter", "Packets by the state they found their flow in and their input symbol.");
+        for (size_t s = 0; s < protocol.states.size(); s++) {
+            for (int sym = 0; sym < SYM_COUNT; sym++) {
+                uint64_t n = 0;
+                for (const auto& b : blocks) n += b->transitionCount(uint8_t(s), Symbol(sym));
+                if (n) line("pda_transitions_total", label("state", protocol.states[s]) + "," + label("input", symbolName(Symbol(sym))), n);
+            }
+        }
+
+        head("pda_alerts_total", "counter", "Flows that entered the trap.");
+        uint64_t alerts = 0;
+        for (const auto& b : blocks) alerts += b->alertCount();
+        line("pda_alerts_total", "", alerts);
+
+        head("pda_verdicts_total", "counter", "Flows settled by a timeout or at the end of the input, by verdict.");
+        for (int v = 0; v < VERDICT_COUNT; v++) {
+            uint64_t n = 0;
+            for (const auto& b : blocks) n += b->verdictCount(Verdict(v));
+            line("pda_verdicts_total", label("verdict", verdictName(Verdict(v))), n);
+        }
+
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0, sumNs = 0;
+        mergeLatency(buckets, count, sumNs);
+        head("pda_step_latency_seconds", "summary", "Time to step one packet through its flow (HDR histogram, ~3% resolution).");
+        for (double q : { 0.5, 0.9, 0.99, 0.999, 1.0 }) {
+            char qs[16], vs[32];
+            std::snprintf(qs, sizeof(qs), "%g", q);
+            std::snprintf(vs, sizeof(vs), "%.9g", double(LatencyHistogram::quantile(buckets, q)) * 1e-9);
+            o += std::string("pda_step_latency_seconds{quantile=\"") + qs + "\"} " + vs + "\n";
+        }
+        char sum[32];
+        std::snprintf(sum, sizeof(sum), "%.9g", double(sumNs) * 1e-9);
+        o += std::string("pda_step_latency_seconds_sum ") + sum + "\n";
+        line("pda_step_latency_seconds_count", "", count);
+        return o;
+    }
+
+private:
+    const PdaTable& protocol;
+    std::vector<std::unique_ptr<FlowMetrics>> blocks;
+
+    void mergeLatency(std::vector<uint64_t>& buckets, uint64_t& count, uint64_t& sumNs) const {
+        buckets.assign(LatencyHistogram::BUCKETS, 0);
+        for (const auto& b : blocks) b->stepLatency().addTo(buckets, count, sumNs);
+    }
+};
+
+// === EXPORTER ===
+// One background thread: answers every HTTP request on 127.0.0.1:<port> with
+// the metrics, and rewrites <file> every `interval` seconds and once on stop().
+class MetricsExporter {
+public:
+    explicit MetricsExporter(const MetricsRegistry& registry) : registry(registry) {}
+    ~MetricsExporter() { stop(); }
+
+    bool start(const std::string& path, double intervalSec, int port, std::string& err) {
+        file = path;
+        interval = std::chrono::milliseconds(int64_t(intervalSec * 1000));
+        if (interval.count() <= 0) interval = std::chrono::milliseconds(1000);
+        if (port > 0 && !listenOn(port, err)) return false;
+        worker = std::thread([this] { run(); });
+        return true;
+    }
+
+    // Final file write, then the thread is gone.
+    void stop() {
+        if (!worker.joinable()) return;
+        stopping.store(true, std::memory_order_release);
+        worker.join();
+        if (!file.empty()) writeFile();
+#if !defined(_WIN32)
+        if (listener >= 0) ::close(listener);
+        listener = -1;
+#endif
+    }
+
+    uint64_t requests() const { return served; }
+    // First failed file write, if any; read after stop().
+    const std::string& error() const { return firstError; }
+
+private:
+    const MetricsRegistry& registry;
+    std::string file;
+    std::chrono::milliseconds interval{ 1000 };
+    std::thread worker;
+    std::atomic<bool> stopping{ false };
+    int listener = -1;
+    uint64_t served = 0;
+    std::string firstError;
+
+    void run() {
+        auto nextWrite = std::chrono::steady_clock::now() + interval;
+        while (!stopping.load(std::memory_order_acquire)) {
+            auto now = std::chrono::steady_clock::now();
+            if (!file.empty() && now >= nextWrite) {
+                writeFile();
+                nextWrite = now + interval;
+            }
+            int waitMs = 200;   // how often stop() is noticed
+            if (!file.empty()) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(nextWrite - now).count();
+                if (left < waitMs) waitMs = int(left < 0 ? 0 : left);
+            }
+            if (listener >= 0) serveOne(waitMs);
+            else std::this_thread::sleep_for(std::chrono::milliseconds(waitMs));
+        }
+    }
+
+    // Write-then-rename, so a reader never sees half a file; on any failure
+    // the temp file goes and the previous snapshot stays.
+    void writeFile() {
+        std::string tmp = file + ".tmp";
+        std::FILE* f = std::fopen(tmp.c_str(), "wb");
+        if (!f) {
+            fail("cannot write " + tmp);
+            return;
+        }
+        std::string text = registry.prometheus();
+        bool written = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+        if (std::fclose(f) != 0 || !written) {
+            std::remove(tmp.c_str());
+            fail("write to " + tmp + " failed");
+            return;
+        }
+        if (std::rename(tmp.c_str(), file.c_str()) != 0) {
+            std::remove(tmp.c_str());
+            fail("cannot replace " + file);
+        }
+    }
+
+    void fail(const std::string& err) {
+        if (firstError.empty()) firstError = err;
+    }
+
+#if !defined(_WIN32)
+    bool listenOn(int port, std::string& err) {
+        listener = ::socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(uint16_t(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listener, 16) != 0) {
+            err = "cannot listen on 127.0.0.1:" + std::to_string(port);
+            if (listener >= 0) ::close(listener);
+            listener = -1;
+            return false;
+        }
+        return true;
+    }
+
+    // Wait up to waitMs for a client; whatever it asks for, it gets the metrics.
+    void serveOne(int waitMs) {
+        pollfd p{ listener, POLLIN, 0 };
+        if (::poll(&p, 1, waitMs) <= 0) return;
+        int c = ::accept(listener, nullptr, nullptr);
+        if (c < 0) return;
+        char req[2048];
+        pollfd r{ c, POLLIN, 0 };
+        if (::poll(&r, 1, 1000) > 0) (void)::recv(c, req, sizeof(req), 0);
+        std::string body = registry.prometheus();
+        std::string resp = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        for (size_t done = 0; done < resp.size();) {
+            ssize_t n = ::send(c, resp.data() + done, resp.size() - done, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            done += size_t(n);
+        }
+        ::close(c);
+        served++;
+    }
+#else
+    bool listenOn(int, std::string& err) {
+        err = "--metrics-port is not supported on this platform (use --metrics-file)";
+        return false;
+    }
+    void serveOne(int waitMs) { std::this_thread::sleep_for(std::chrono::milliseconds(waitMs)); }
+#endif
+};
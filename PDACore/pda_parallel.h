@@ -0,0 +1,240 @@
+#pragma once
+// === SHARDED MULTI-CORE VALIDATION ===
+// A dispatcher thread hashes every packet's flow key to one of N workers and
+// hands it over through a lock-free single-producer / single-consumer ring.
+// Each worker owns its own FlowValidator (its shard of the flow table), so no
+// flow state is ever shared and the hot path takes no locks at all.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "pda_flows.h"
+
+// === SPSC RING ===
+// Classic bounded ring with monotonically increasing head/tail counters. Each
+// side also caches the other side's counter, so the shared cache line is only
+// read again when the ring looks full (producer) or empty (consumer).
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacityPow2) : buf(capacityPow2), mask(capacityPow2 - 1) {}
+
+    // Producer side: copy up to n items in, returns how many fit.
+    size_t pushMany(const T* items, size_t n) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t room = buf.size() - (t - cachedHead);
+        if (room < n) {
+            cachedHead = head.load(std::memory_order_acquire);
+            room = buf.size() - (t - cachedHead);
+            if (n > room) n = room;
+        }
+        for (size_t i = 0; i < n; i++) buf[(t + i) & mask] = items[i];
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side: move up to max items out, returns how many there were.
+    size_t popMany(T* out, size_t max) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t avail = cachedTail - h;
+        if (avail == 0) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            avail = cachedTail - h;
+            if (avail == 0) return 0;
+        }
+        if (avail > max) avail = max;
+        for (size_t i = 0; i < avail; i++) out[i] = buf[(h + i) & mask];
+        head.store(h + avail, std::memory_order_release);
+        return avail;
+    }
+
+private:
+    std::vector<T> buf;
+    const size_t mask;
+    alignas(64) std::atomic<size_t> head{0};   // written by the consumer
+    size_t cachedTail = 0;                     // consumer's copy of tail
+    alignas(64) std::atomic<size_t> tail{0};   // written by the producer
+    size_t cachedHead = 0;                     // producer's copy of head
+};
+
+// Short busy-wait, then give the core away (rings are only full/empty under
+// imbalance, and oversubscribed machines must still make progress).
+inline void backoff(unsigned& spins) {
+    if (++spins < 64) return;
+    std::this_thread::yield();
+}
+
+// === SHARDED VALIDATOR ===
+// The payload pointer must stay valid until finish() (e.g. a mapped capture).
+// A captured segment carries its raw flags and direction instead of a symbol,
+// and its timestamp drives the shard's timeouts.
+struct ShardPacket {
+    FlowKey key;
+    uint32_t hash;
+    Symbol sym;
+    bool segment;
+    bool reversed;
+    uint8_t tcpFlags;
+    bool hasPayload;
+    const uint8_t* payload;
+    size_t payloadLen;
+    uint64_t tsNanos;
+};
+
+class ShardedValidator {
+public:
+    // With timeouts, flows a shard evicts are counted in the stats but not
+    // passed to finish()'s callback. halfOpenFlows > 0 gives every shard its
+    // share of a half-open filter (FlowValidator::setHalfOpenFilter).
+    ShardedValidator(const PdaTable& protocol, unsigned workers, size_t expectedFlows = 1 << 16,
+                     const SignatureSet* signatures = nullptr, const FlowTimeouts& timeouts = FlowTimeouts(),
+                     size_t halfOpenFlows = 0) {
+        if (workers == 0) workers = 1;
+        for (unsigned i = 0; i < workers; i++)
+            shards.emplace_back(new Shard(protocol, expectedFlows / workers + 1, signatures, timeouts,
+                                          halfOpenFlows ? halfOpenFlows / workers + 1 : 0));
+        for (auto& s : shards) {
+            Shard* sh = s.get();
+            sh->thread = std::thread([sh] { sh->run(); });
+        }
+    }
+
+    ~ShardedValidator() { stop(); }
+
+    unsigned workers() const { return unsigned(shards.size()); }
+
+    // fn(unsigned shard, const FlowSlot&, const FlowAlert&) on the worker that
+    // trapped the flow, so fn must be safe to call from all of them at once.
+    // Set before the first dispatch.
+    template <typename Fn>
+    void setAlertHook(Fn fn) {
+        for (unsigned i = 0; i < shards.size(); i++)
+            shards[i]->validator.setAlertHook([fn, i](const FlowSlot& s, const FlowAlert& a) { fn(i, s, a); });
+    }
+
+    // One FlowMetrics block per worker from the registry. Set before the first dispatch.
+    void setMetrics(MetricsRegistry& registry) {
+        for (auto& s : shards) s->validator.setMetrics(registry.add());
+    }
+
+    // One span ring per worker ("worker <i>"). Set before the first dispatch.
+    void setSpans(SpanTracer& tracer) {
+        for (size_t i = 0; i < shards.size(); i++) shards[i]->validator.setSpans(tracer.thread("worker " + std::to_string(i)));
+    }
+
+    // Dispatcher side. Packets are staged per worker and published in batches,
+    // so the ring's shared counters move once per BATCH packets, not per packet.
+    void dispatch(const FlowKey& key, Symbol sym, const uint8_t* payload = nullptr, size_t payloadLen = 0) {
+        uint32_t h = hashFlowKey(key);
+        // Multiply-shift maps the hash onto [0, workers) without a division
+        Shard& s = *shards[(uint64_t(h) * shards.size()) >> 32];
+        s.staged[s.stagedCount++] = ShardPacket{ key, h, sym, false, false, 0, false, payload, payloadLen, 0 };
+        if (s.stagedCount == BATCH) publish(s);
+    }
+
+    // Captured segment, see FlowValidator::onSegment.
+    void dispatchSegment(const FlowKey& key, bool reversed, uint8_t tcpFlags, bool hasPayload = false,
+                         const uint8_t* payload = nullptr, size_t payloadLen = 0, uint64_t tsNanos = 0) {
+        uint32_t h = hashFlowKey(key);
+        Shard& s = *shards[(uint64_t(h) * shards.size()) >> 32];
+        s.staged[s.stagedCount++] = ShardPacket{ key, h, SYM_DATA, true, reversed, tcpFlags, hasPayload, payload, payloadLen, tsNanos };
+        if (s.stagedCount == BATCH) publish(s);
+    }
+
+    // Flush, stop and join the workers, then settle every flow's verdict.
+    // fn(const FlowSlot&, Verdict) sees each flow once, shard by shard.
+    template <typename Fn>
+    FlowStats finish(Fn&& fn) {
+        stop();
+        FlowStats total;
+        for (auto& s : shards) {
+            s->validator.finish(fn);
+            const FlowStats& st = s->validator.getStats();
+            total.packets += st.packets;
+            total.flows += st.flows;
+            total.alerts += st.alerts;
+            total.blocked += st.blocked;
+            total.signatures += st.signatures;
+            total.expired += st.expired;
+            total.peakFlows += st.peakFlows;   // sum of the shards' peaks
+            total.halfOpen += st.halfOpen;
+            total.promoted += st.promoted;
+            for (int v = 0; v < VERDICT_COUNT; v++) total.verdicts[v] += st.verdicts[v];
+        }
+        return total;
+    }
+
+    FlowStats finish() { return finish([](const FlowSlot&, Verdict) {}); }
+
+private:
+    static const size_t BATCH = 64;
+    static const size_t RING = 1 << 14;
+
+    struct Shard {
+        FlowValidator validator;
+        SpscRing<ShardPacket> ring;
+        std::atomic<bool> done{false};
+        std::thread thread;
+        ShardPacket staged[BATCH];   // dispatcher-owned staging buffer
+        size_t stagedCount = 0;
+
+        bool timed;
+
+        Shard(const PdaTable& p, size_t flows, const SignatureSet* sigs, const FlowTimeouts& timeouts, size_t halfOpen)
+            : validator(p, flows, sigs), ring(RING), timed(timeouts.enabled()) {
+            validator.setTimeouts(timeouts);
+            validator.setHalfOpenFilter(halfOpen);
+        }
+
+        void run() {
+            ShardPacket batch[BATCH];
+            unsigned spins = 0;
+            for (;;) {
+                size_t n = ring.popMany(batch, BATCH);
+                if (n == 0) {
+                    if (!done.load(std::memory_order_acquire)) {
+                        backoff(spins);
+                        continue;
+                    }
+                    // done is stored after the last publish, so this pop sees everything
+                    n = ring.popMany(batch, BATCH);
+                    if (n == 0) return;
+                }
+                spins = 0;
+                for (size_t i = 0; i < n; i++) validator.flows().prefetch(batch[i].hash);
+                for (size_t i = 0; i < n; i++) {
+                    const ShardPacket& p = batch[i];
+                    if (timed) validator.advance(p.tsNanos);
+                    if (p.segment) validator.onSegment(p.key, p.hash, p.reversed, p.tcpFlags, p.hasPayload, p.payload, p.payloadLen);
+                    else validator.onPacket(p.key, p.hash, p.sym, p.payload, p.payloadLen);
+                }
+            }
+        }
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    bool stopped = false;
+
+    void publish(Shard& s) {
+        size_t sent = 0;
+        unsigned spins = 0;
+        while (sent < s.stagedCount) {
+            size_t n = s.ring.pushMany(s.staged + sent, s.stagedCount - sent);
+            sent += n;
+            if (n == 0) backoff(spins);
+        }
+        s.stagedCount = 0;
+    }
+
+    void stop() {
+        if (stopped) return;
+        stopped = true;
+        for (auto& s : shards) {
+            publish(*s);
+            s->done.store(true, std::memory_order_release);
+        }
+        for (auto& s : shards) s->thread.join();
+    }
+};
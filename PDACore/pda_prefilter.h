@@ -0,0 +1,187 @@
+#pragma once
+// === LITERAL PREFILTER ===
+// Finds where any of the literals every signature requires could occur, so the
+// signature DFA only runs near those spots. Cheap tests pick candidate
+// positions: literals of 4+ bytes by a 64K-bit set over a hash of their first
+// four bytes, 2-3 byte ones by a 64K-bit set of their first byte pair, single
+// bytes by a 256-entry table. Each candidate is confirmed by
+// walking the literal trie (the goto function of an Aho-Corasick automaton;
+// candidates are anchored at a literal's first byte, so no failure links are
+// needed). With AVX2 eight positions are hashed and tested per step, each set
+// lookup done by one gather; other CPUs run the same tests byte by byte.
+// Literals match ASCII case-insensitively: the filter only has to be a
+// superset, every candidate region is confirmed by the exact DFA.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "pda_simd.h"
+
+namespace pda_detail {
+
+inline uint8_t foldByte(uint8_t b) { return (b >= 'A' && b <= 'Z') ? uint8_t(b + 32) : b; }
+
+// Keys of the two bit sets. OR-ing 0x20 folds letters (and maps both sides alike).
+inline uint32_t literalHash4(uint32_t v) { return ((v | 0x20202020u) * 0x9E3779B1u) >> 16; }
+inline uint32_t literalPair(uint32_t v) { return (v | 0x2020u) & 0xFFFFu; }
+
+} // namespace pda_detail
+
+class LiteralPrefilter {
+public:
+    static const size_t NONE = size_t(-1);
+
+    // Literals must be non-empty and already folded to lower case.
+    void build(const std::vector<std::string>& literals, SimdPath simd = detectSimdPath()) {
+        *this = LiteralPrefilter();
+        path = simd;
+
+        // Byte classes for the trie: one per literal byte (both cases), the rest share 0
+        int classes = 1;
+        for (const std::string& lit : literals)
+            for (char ch : lit) {
+                uint8_t b = uint8_t(ch);
+                if (cls[b]) continue;
+                cls[b] = uint8_t(classes);
+                if (b >= 'a' && b <= 'z') cls[b - 32] = uint8_t(classes);
+                classes++;
+            }
+        while ((1u << shift) < unsigned(classes)) shift++;
+
+        child.assign(size_t(1) << shift, 0);
+        final.assign(1, 0);
+        for (const std::string& lit : literals) {
+            uint32_t s = 0;
+            for (char ch : lit) {
+                size_t k = (size_t(s) << shift) | cls[uint8_t(ch)];
+                if (!child[k]) {
+                    child[k] = uint32_t(final.size());
+                    final.push_back(0);
+                    child.resize(child.size() + (size_t(1) << shift), 0);
+                }
+                s = child[k];
+            }
+            final[s] = 1;
+
+            uint32_t v = 0;
+            std::memcpy(&v, lit.data(), std::min<size_t>(lit.size(), 4));
+            if (lit.size() >= 4) {
+                uint32_t h = pda_detail::literalHash4(v);
+                hashBits[h >> 5] |= 1u << (h & 31);
+            } else if (lit.size() >= 2) {
+                anyPair = true;
+                uint32_t h = pda_detail::literalPair(v);
+                pairBits[h >> 5] |= 1u << (h & 31);
+            } else {
+                anySingle = true;
+                uint8_t first = uint8_t(lit[0]);
+                for (uint8_t b : { first, uint8_t(first >= 'a' && first <= 'z' ? first - 32 : first) }) {
+                    singleStart[b] = 1;
+                    singleLo[b & 15] |= uint8_t(1u << (b >> 4 & 7));
+                    singleHi[b >> 4] |= uint8_t(1u << (b >> 4 & 7));
+                }
+            }
+        }
+    }
+
+    // Smallest j >= i such that a whole literal occurs at p[j, j + len) within
+    // p[i, n), or NONE.
+    size_t findStart(const uint8_t* p, size_t i, size_t n) const {
+#ifdef PDA_HAVE_AVX2_PATH
+        if (path == SIMD_AVX2) return findAvx2(p, i, n);
+#endif
+        return findScalar(p, i, n);
+    }
+
+    size_t trieStates() const { return final.size(); }
+    size_t tableBytes() const { return child.size() * sizeof(uint32_t) + sizeof(hashBits) + sizeof(pairBits); }
+    SimdPath simdPath() const { return path; }
+
+private:
+    std::vector<uint32_t> child;    // trie goto, [node << shift | class], 0 = none
+    std::vector<uint8_t> final;     // node completes a literal
+    uint8_t cls[256] = {};
+    unsigned shift = 0;
+    alignas(64) uint32_t hashBits[2048] = {};   // 65536-bit set of literalHash4(first 4 bytes)
+    alignas(64) uint32_t pairBits[2048] = {};   // 65536-bit set of the first 2 bytes, 2-3 byte literals
+    uint8_t singleStart[256] = {};              // 1-byte literals
+    alignas(16) uint8_t singleLo[16] = {};      // the same set as nibble masks (shufti)
+    alignas(16) uint8_t singleHi[16] = {};
+    bool anyPair = false, anySingle = false;
+    SimdPath path = SIMD_SCALAR;
+
+    bool verify(const uint8_t* p, size_t j, size_t n) const {
+        uint32_t s = 0;
+        for (size_t k = j; k < n; k++) {
+            s = child[(size_t(s) << shift) | cls[p[k]]];
+            if (!s) return false;
+            if (final[s]) return true;
+        }
+        return false;
+    }
+
+    bool candidate(const uint8_t* p, size_t j, size_t n) const {
+        if (singleStart[p[j]]) return true;
+        if (j + 2 > n) return false;
+        uint32_t v = 0;
+        if (j + 4 <= n) std::memcpy(&v, p + j, 4);
+        else std::memcpy(&v, p + j, n - j);
+        uint32_t pair = pda_detail::literalPair(v);
+        if (anyPair && ((pairBits[pair >> 5] >> (pair & 31)) & 1)) return true;
+        if (j + 4 > n) return false;
+        uint32_t h = pda_detail::literalHash4(v);
+        return (hashBits[h >> 5] >> (h & 31)) & 1;
+    }
+
+    size_t findScalar(const uint8_t* p, size_t j, size_t n) const {
+        for (; j < n; j++)
+            if (candidate(p, j, n) && verify(p, j, n)) return j;
+        return NONE;
+    }
+
+#ifdef PDA_HAVE_AVX2_PATH
+    __attribute__((target("avx2")))
+    size_t findAvx2(const uint8_t* p, size_t j, size_t n) const {
+        // Lane k of the 256-bit vector gets bytes j+k .. j+k+3 (both halves hold p[j, j+16))
+        const __m256i spread = _mm256_setr_epi8(0, 1, 2, 3, 1, 2, 3, 4, 2, 3, 4, 5, 3, 4, 5, 6,
+                                                4, 5, 6, 7, 5, 6, 7, 8, 6, 7, 8, 9, 7, 8, 9, 10);
+        const __m256i fold = _mm256_set1_epi32(0x20202020);
+        const __m256i mul = _mm256_set1_epi32(int(0x9E3779B1u));
+        const __m256i low5 = _mm256_set1_epi32(31);
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i nibble = _mm256_set1_epi8(0x0F);
+        const __m256i byte0 = _mm256_set1_epi32(0xFF);
+        const __m256i pairFold = _mm256_set1_epi32(0x2020);
+        const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+        const __m256i lo = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(singleLo)));
+        const __m256i hi = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(singleHi)));
+        for (; j + 16 <= n; j += 8) {
+            __m256i bytes = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j)));
+            __m256i raw = _mm256_shuffle_epi8(bytes, spread);
+            __m256i h = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_or_si256(raw, fold), mul), 16);
+            __m256i word = _mm256_i32gather_epi32(reinterpret_cast<const int*>(hashBits), _mm256_srli_epi32(h, 5), 4);
+            __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(h, low5)), one);
+            __m256i hit = _mm256_cmpeq_epi32(bit, one);
+            if (anyPair) {
+                __m256i k = _mm256_and_si256(_mm256_or_si256(raw, pairFold), low16);
+                __m256i w = _mm256_i32gather_epi32(reinterpret_cast<const int*>(pairBits), _mm256_srli_epi32(k, 5), 4);
+                __m256i b = _mm256_and_si256(_mm256_srlv_epi32(w, _mm256_and_si256(k, low5)), one);
+                hit = _mm256_or_si256(hit, _mm256_cmpeq_epi32(b, one));
+            }
+            if (anySingle) {
+                __m256i l = _mm256_shuffle_epi8(lo, _mm256_and_si256(raw, nibble));
+                __m256i u = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(raw, 4), nibble));
+                __m256i first = _mm256_and_si256(_mm256_and_si256(l, u), byte0);
+                hit = _mm256_or_si256(hit, _mm256_cmpgt_epi32(first, _mm256_setzero_si256()));
+            }
+            for (unsigned m = unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(hit))); m; m &= m - 1) {
+                size_t k = j + size_t(__builtin_ctz(m));
+                if (verify(p, k, n)) return k;
+            }
+        }
+        return findScalar(p, j, n);
+    }
+#endif
+};
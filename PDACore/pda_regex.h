@@ -0,0 +1,837 @@
+#pragma once
+// === SIGNATURE ENGINE: REGEX -> MINIMIZED DFA ===
+// Malicious payload signatures are regular expressions, compiled the textbook
+// way: Thompson construction (regex -> NFA with epsilon moves), subset
+// construction (NFA -> DFA) and Hopcroft minimization. All signatures share one
+// DFA over byte equivalence classes, stored as a dense 64-byte aligned table,
+// so scanning costs one load per payload byte. The DFA state is a plain
+// integer: a flow keeps it between packets, so a signature split across two
+// segments is still found without reassembling the stream. A literal
+// prefilter (pda_prefilter.h) keeps the DFA off payloads that cannot match.
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "pda_prefilter.h"
+
+// === BUILT-IN SIGNATURES ===
+// Same text as PDACore/protocols/signatures.rules. Pass --sigs <file> to override.
+const char* const DEFAULT_SIGNATURES = R"SIG(
+sig path_traversal:        (\.\./)+etc/(passwd|shadow)
+sig shell_spawn:           /bin/(ba|z|c)?sh
+sig sql_union nocase:      union\s+(all\s+)?select
+sig php_eval nocase:       eval\s*\(\s*base64_decode
+sig nop_sled:              \x90{16}
+)SIG";
+
+// The flow table keeps the scan state in 15 bits (see FlowSlot::scan).
+constexpr size_t SIGNATURE_MAX_STATES = 0x7FFF;
+
+namespace pda_detail {
+
+typedef std::bitset<256> ByteSet;
+
+inline int singleByte(const ByteSet& s) {
+    if (s.count() != 1) return -1;
+    for (int b = 0; b < 256; b++) if (s[b]) return b;
+    return -1;
+}
+
+// --- SYNTAX TREE ---
+struct RegexNode {
+    enum Kind : uint8_t { SET, CAT, ALT, STAR, PLUS, OPT, REPEAT, EMPTY } kind = EMPTY;
+    ByteSet set;                // SET: the bytes this position accepts
+    int min = 0, max = 0;       // REPEAT: max < 0 = unbounded
+    int a = -1, b = -1;         // children (node indices)
+};
+
+// Supported: literals, '.', [...] / [^...] with ranges, \d \w \s (and \D \W \S),
+// \xHH \n \r \t \0, '\' before any other byte, ( ), |, * + ?, {m} {m,} {m,n}.
+// A match may start anywhere in the payload stream; there are no anchors.
+class RegexParser {
+public:
+    RegexParser(const std::string& src, bool nocase, std::vector<RegexNode>& nodes)
+        : src(src), nocase(nocase), nodes(nodes) {}
+
+    // Returns the root node, or -1 with err filled.
+    int parse(std::string& err) {
+        int root = parseAlt();
+        if (root >= 0 && pos < src.size()) root = fail("unbalanced ')'");
+        err = error;
+        return root;
+    }
+
+private:
+    const std::string& src;
+    bool nocase;
+    std::vector<RegexNode>& nodes;
+    size_t pos = 0;
+    std::string error;
+
+    bool more() const { return pos < src.size(); }
+    int fail(const std::string& msg) {
+        if (error.empty()) error = msg + " at offset " + std::to_string(pos);
+        return -1;
+    }
+    int add(RegexNode::Kind kind, int a = -1, int b = -1) {
+        RegexNode n;
+        n.kind = kind;
+        n.a = a;
+        n.b = b;
+        nodes.push_back(n);
+        return int(nodes.size()) - 1;
+    }
+
+    int parseAlt() {
+        int left = parseCat();
+        while (left >= 0 && more() && src[pos] == '|') {
+            pos++;
+            int right = parseCat();
+            left = right < 0 ? -1 : add(RegexNode::ALT, left, right);
+        }
+        return left;
+    }
+
+    int parseCat() {
+        int left = -1;
+        while (more() && src[pos] != '|' && src[pos] != ')') {
+            int right = parseRepeat();
+            if (right < 0) return -1;
+            left = left < 0 ? right : add(RegexNode::CAT, left, right);
+        }
+        return left < 0 ? add(RegexNode::EMPTY) : left;
+    }
+
+    int parseRepeat() {
+        int atom = parseAtom();
+        while (atom >= 0 && more()) {
+            char c = src[pos];
+            if (c == '*') { pos++; atom = add(RegexNode::STAR, atom); }
+            else if (c == '+') { pos++; atom = add(RegexNode::PLUS, atom); }
+            else if (c == '?') { pos++; atom = add(RegexNode::OPT, atom); }
+            else if (c == '{') {
+                pos++;
+                int lo = parseCount(), hi = lo;
+                if (more() && src[pos] == ',') {
+                    pos++;
+                    hi = (more() && src[pos] == '}') ? -1 : parseCount();
+                }
+                if (lo < 0 || (hi < 0 && src[pos - 1] != ',') || !more() || src[pos] != '}')
+                    return fail("malformed {m,n} repeat");
+                pos++;
+                if (hi >= 0 && hi < lo) return fail("repeat {m,n} with n < m");
+                int r = add(RegexNode::REPEAT, atom);
+                nodes[r].min = lo;
+                nodes[r].max = hi;
+                atom = r;
+            }
+            else break;
+        }
+        return atom;
+    }
+
+    int parseCount() {
+        int n = -1;
+        while (more() && src[pos] >= '0' && src[pos] <= '9') {
+            n = (n < 0 ? 0 : n) * 10 + (src[pos++] - '0');
+            if (n > 255) return fail("repeat count above 255");
+        }
+        return n;
+    }
+
+    int parseAtom() {
+        char c = src[pos++];
+        if (c == '(') {
+            int inner = parseAlt();
+            if (inner < 0) return -1;
+            if (!more() || src[pos] != ')') return fail("missing ')'");
+            pos++;
+            return inner;
+        }
+        if (c == '*' || c == '+' || c == '?' || c == '{') return fail("nothing to repeat");
+        ByteSet set;
+        if (c == '.') set.set();
+        else if (c == '[') { if (!parseClass(set)) return -1; }
+        else if (c == '\\') { if (!parseEscape(set)) return -1; }
+        else set.set(uint8_t(c));
+        if (nocase) {
+            for (int l = 'a'; l <= 'z'; l++)
+                if (set[l] || set[l - 32]) { set.set(l); set.set(l - 32); }
+        }
+        int n = add(RegexNode::SET);
+        nodes[n].set = set;
+        return n;
+    }
+
+    bool parseEscape(ByteSet& set) {
+        if (!more()) { fail("trailing '\\'"); return false; }
+        char c = src[pos++];
+        switch (c) {
+        case 'd': case 'D':
+            for (int b = '0'; b <= '9'; b++) set.set(b);
+            break;
+        case 'w': case 'W':
+            for (int b = 0; b < 256; b++)
+                if ((b >= '0' && b <= '9') || (b >= 'a' && b <= 'z') || (b >= 'A' && b <= 'Z') || b == '_') set.set(b);
+            break;
+        case 's': case 'S':
+            for (char b : std::string(" \t\r\n\f\v")) set.set(uint8_t(b));
+            break;
+        case 'n': set.set('\n'); break;
+        case 'r': set.set('\r'); break;
+        case 't': set.set('\t'); break;
+        case '0': set.set(0); break;
+        case 'x': {
+            int v = 0;
+            for (int i = 0; i < 2; i++) {
+                char h = more() ? src[pos++] : 0;
+                int d = (h >= '0' && h <= '9') ? h - '0' : (h >= 'a' && h <= 'f') ? h - 'a' + 10
+                      : (h >= 'A' && h <= 'F') ? h - 'A' + 10 : -1;
+                if (d < 0) { fail("\\x needs two hex digits"); return false; }
+                v = v * 16 + d;
+            }
+            set.set(v);
+            break;
+        }
+        default: set.set(uint8_t(c));
+        }
+        if (c == 'D' || c == 'W' || c == 'S') set.flip();
+        return true;
+    }
+
+    bool parseClass(ByteSet& set) {
+        bool negate = more() && src[pos] == '^';
+        if (negate) pos++;
+        for (bool first = true;; first = false) {
+            if (!more()) { fail("missing ']'"); return false; }
+            char c = src[pos++];
+            if (c == ']' && !first) break;
+            ByteSet item;
+            if (c == '\\') { if (!parseEscape(item)) return false; }
+            else item.set(uint8_t(c));
+            int lo = singleByte(item);
+            if (lo >= 0 && pos + 1 < src.size() && src[pos] == '-' && src[pos + 1] != ']') {
+                pos++;
+                ByteSet end;
+                char d = src[pos++];
+                if (d == '\\') { if (!parseEscape(end)) return false; }
+                else end.set(uint8_t(d));
+                int hi = singleByte(end);
+                if (hi < lo) { fail("bad range in [...]"); return false; }
+                for (int b = lo; b <= hi; b++) item.set(b);
+            }
+            set |= item;
+        }
+        if (negate) set.flip();
+        return true;
+    }
+};
+
+// --- THOMPSON NFA ---
+struct NfaState {
+    ByteSet on;             // bytes that lead to `out`
+    int out = -1;
+    std::vector<int> eps;   // epsilon moves
+    int accept = -1;        // signature index of a final state
+};
+
+class ThompsonBuilder {
+public:
+    ThompsonBuilder(const std::vector<RegexNode>& nodes, std::vector<NfaState>& nfa) : nodes(nodes), nfa(nfa) {}
+
+    struct Frag { int start, end; };   // `end` never has outgoing edges yet
+
+    Frag build(int n) {
+        const RegexNode& r = nodes[n];
+        switch (r.kind) {
+        case RegexNode::SET: {
+            int s = fresh(), e = fresh();
+            nfa[s].on = r.set;
+            nfa[s].out = e;
+            return { s, e };
+        }
+        case RegexNode::CAT: {
+            Frag x = build(r.a), y = build(r.b);
+            link(x.end, y.start);
+            return { x.start, y.end };
+        }
+        case RegexNode::ALT: {
+            Frag x = build(r.a), y = build(r.b);
+            int s = fresh(), e = fresh();
+            link(s, x.start); link(s, y.start);
+            link(x.end, e); link(y.end, e);
+            return { s, e };
+        }
+        case RegexNode::STAR: return star(build(r.a));
+        case RegexNode::PLUS: {
+            Frag x = build(r.a);
+            int e = fresh();
+            link(x.end, x.start); link(x.end, e);
+            return { x.start, e };
+        }
+        case RegexNode::OPT: return opt(build(r.a));
+        case RegexNode::REPEAT: {
+            // x{m,n} = m copies of x, then n-m optional copies (or x* if unbounded)
+            int s = fresh();
+            Frag all{ s, s };
+            int optional = r.max < 0 ? 1 : r.max - r.min;
+            for (int i = 0; i < r.min + optional; i++) {
+                Frag x = build(r.a);
+                if (i >= r.min) x = r.max < 0 ? star(x) : opt(x);
+                link(all.end, x.start);
+                all.end = x.end;
+            }
+            return all;
+        }
+        case RegexNode::EMPTY: break;
+        }
+        int s = fresh();
+        return { s, s };
+    }
+
+private:
+    const std::vector<RegexNode>& nodes;
+    std::vector<NfaState>& nfa;
+
+    int fresh() { nfa.emplace_back(); return int(nfa.size()) - 1; }
+    void link(int from, int to) { nfa[from].eps.push_back(to); }
+    Frag star(Frag x) {
+        int s = fresh(), e = fresh();
+        link(s, x.start); link(s, e);
+        link(x.end, x.start); link(x.end, e);
+        return { s, e };
+    }
+    Frag opt(Frag x) {
+        int s = fresh(), e = fresh();
+        link(s, x.start); link(s, e);
+        link(x.end, e);
+        return { s, e };
+    }
+};
+
+// --- HOPCROFT MINIMIZATION ---
+// trans[s * k + c] is the complete DFA; states with different labels (sets of
+// matched signatures) are never merged. Returns each state's block.
+inline std::vector<int> hopcroftMinimize(const std::vector<int>& trans, int k, const std::vector<int>& label, int& blockCount) {
+    const int n = int(label.size());
+    // Inverse edges in CSR form, indexed by target * k + class
+    std::vector<int> invStart(size_t(n) * k + 1, 0), inv(size_t(n) * k);
+    for (size_t i = 0; i < trans.size(); i++) invStart[size_t(trans[i]) * k + i % k + 1]++;
+    for (size_t i = 1; i < invStart.size(); i++) invStart[i] += invStart[i - 1];
+    std::vector<int> fill(invStart.begin(), invStart.end() - 1);
+    for (size_t i = 0; i < trans.size(); i++) inv[fill[size_t(trans[i]) * k + i % k]++] = int(i / k);
+
+    std::vector<std::vector<int>> members;
+    std::vector<int> blockOf(n);
+    std::map<int, int> byLabel;
+    for (int s = 0; s < n; s++) {
+        auto it = byLabel.emplace(label[s], int(members.size())).first;
+        if (it->second == int(members.size())) members.emplace_back();
+        members[it->second].push_back(s);
+        blockOf[s] = it->second;
+    }
+
+    std::vector<int> work;
+    std::vector<char> inWork(members.size(), 1);
+    for (size_t b = 0; b < members.size(); b++) work.push_back(int(b));
+
+    std::vector<char> marked(n, 0);
+    std::vector<std::vector<int>> hits(members.size());
+    std::vector<int> touched;
+    while (!work.empty()) {
+        int a = work.back();
+        work.pop_back();
+        inWork[a] = 0;
+        const std::vector<int> splitter = members[a];
+        for (int c = 0; c < k; c++) {
+            touched.clear();
+            for (int t : splitter) {
+                size_t key = size_t(t) * k + c;
+                for (int i = invStart[key]; i < invStart[key + 1]; i++) {
+                    int s = inv[i];
+                    if (marked[s]) continue;
+                    marked[s] = 1;
+                    int b = blockOf[s];
+                    if (hits[b].empty()) touched.push_back(b);
+                    hits[b].push_back(s);
+                }
+            }
+            for (int b : touched) {
+                std::vector<int> in;
+                in.swap(hits[b]);
+                if (in.size() < members[b].size()) {
+                    int nb = int(members.size());
+                    std::vector<int> rest;
+                    for (int s : members[b]) if (!marked[s]) rest.push_back(s);
+                    members[b].swap(rest);
+                    for (int s : in) blockOf[s] = nb;
+                    members.push_back(in);
+                    hits.emplace_back();
+                    inWork.push_back(0);
+                    // Either half is enough as a splitter unless b is still queued
+                    int pick = (inWork[b] || members[nb].size() <= members[b].size()) ? nb : b;
+                    if (!inWork[pick]) { inWork[pick] = 1; work.push_back(pick); }
+                }
+                for (int s : in) marked[s] = 0;
+            }
+        }
+    }
+    blockCount = int(members.size());
+    return blockOf;
+}
+
+// --- REQUIRED LITERALS ---
+// What every match of a sub-expression must contain, for the prefilter: the
+// exact string it always matches (if any), the prefix and suffix every match
+// shares, and the best literal factor together with the furthest distance
+// from the match start at which that factor can end. Only factors with a
+// bounded distance are kept, so a literal hit tells where the match began.
+// Bytes are folded to lower case (the prefilter is case-insensitive).
+struct LiteralInfo {
+    bool isExact = true;
+    std::string exact, prefix, suffix, factor;
+    int factorEnd = 0;
+    int maxLen = 0;             // longest match, -1 = unbounded
+};
+
+constexpr size_t LITERAL_MAX = 16;
+
+inline void offerFactor(LiteralInfo& x, std::string f, int end) {
+    if (end < 0) return;
+    if (f.size() > LITERAL_MAX) {   // keep the front of a long literal, it ends sooner
+        end -= int(f.size() - LITERAL_MAX);
+        f.resize(LITERAL_MAX);
+    }
+    if (f.size() > x.factor.size() || (f.size() == x.factor.size() && end < x.factorEnd)) {
+        x.factor = f;
+        x.factorEnd = end;
+    }
+}
+
+inline LiteralInfo literalCat(const LiteralInfo& a, const LiteralInfo& b) {
+    LiteralInfo r;
+    r.maxLen = (a.maxLen < 0 || b.maxLen < 0) ? -1 : a.maxLen + b.maxLen;
+    r.isExact = a.isExact && b.isExact;
+    if (r.isExact) r.exact = a.exact + b.exact;
+    r.prefix = a.isExact ? a.exact + b.prefix : a.prefix;
+    r.suffix = b.isExact ? a.suffix + b.exact : b.suffix;
+    offerFactor(r, a.factor, a.factorEnd);
+    offerFactor(r, b.factor, (a.maxLen < 0 || b.factorEnd < 0) ? -1 : a.maxLen + b.factorEnd);
+    offerFactor(r, a.suffix + b.prefix, a.maxLen < 0 ? -1 : a.maxLen + int(b.prefix.size()));
+    offerFactor(r, r.prefix, int(r.prefix.size()));
+    return r;
+}
+
+// Matches of unknown content and length at most maxLen (-1 = unbounded).
+inline LiteralInfo literalOpaque(int maxLen) {
+    LiteralInfo r;
+    r.isExact = false;
+    r.maxLen = maxLen;
+    return r;
+}
+
+inline LiteralInfo requiredLiteral(const std::vector<RegexNode>& nodes, int n) {
+    const RegexNode& r = nodes[n];
+    switch (r.kind) {
+    case RegexNode::SET: {
+        int b = singleByte(r.set);
+        if (b < 0 && r.set.count() == 2) {     // a nocase letter
+            for (int l = 'a'; l <= 'z'; l++)
+                if (r.set[l] && r.set[l - 32]) b = l;
+        }
+        if (b < 0) return literalOpaque(1);
+        LiteralInfo x;
+        x.exact = x.prefix = x.suffix = x.factor = std::string(1, char(foldByte(uint8_t(b))));
+        x.factorEnd = x.maxLen = 1;
+        return x;
+    }
+    case RegexNode::CAT:
+        return literalCat(requiredLiteral(nodes, r.a), requiredLiteral(nodes, r.b));
+    case RegexNode::ALT: {
+        LiteralInfo a = requiredLiteral(nodes, r.a), b = requiredLiteral(nodes, r.b), x;
+        x.isExact = a.isExact && b.isExact && a.exact == b.exact;
+        x.exact = x.isExact ? a.exact : "";
+        size_t p = 0, q = 0;
+        while (p < a.prefix.size() && p < b.prefix.size() && a.prefix[p] == b.prefix[p]) p++;
+        while (q < a.suffix.size() && q < b.suffix.size() && a.suffix[a.suffix.size() - 1 - q] == b.suffix[b.suffix.size() - 1 - q]) q++;
+        x.prefix = a.prefix.substr(0, p);
+        x.suffix = a.suffix.substr(a.suffix.size() - q);
+        x.maxLen = (a.maxLen < 0 || b.maxLen < 0) ? -1 : std::max(a.maxLen, b.maxLen);
+        offerFactor(x, x.prefix, int(x.prefix.size()));
+        return x;
+    }
+    case RegexNode::STAR: return literalOpaque(-1);
+    case RegexNode::OPT: return literalOpaque(requiredLiteral(nodes, r.a).maxLen);
+    case RegexNode::PLUS: {
+        LiteralInfo x = requiredLiteral(nodes, r.a);
+        x.isExact = false;
+        x.exact.clear();
+        x.maxLen = -1;
+        return x;
+    }
+    case RegexNode::REPEAT: {
+        LiteralInfo a = requiredLiteral(nodes, r.a);
+        int optional = r.max < 0 ? -1 : r.max - r.min;
+        LiteralInfo tail = literalOpaque((optional < 0 || a.maxLen < 0) ? -1 : a.maxLen * optional);
+        if (r.min == 0) return tail;
+        LiteralInfo x = a;
+        for (int i = 1; i < r.min; i++) x = literalCat(x, a);
+        return optional == 0 ? x : literalCat(x, tail);
+    }
+    case RegexNode::EMPTY: break;
+    }
+    return LiteralInfo();
+}
+
+} // namespace pda_detail
+
+// === SIGNATURE SET ===
+class SignatureSet {
+public:
+    std::vector<std::string> names;
+    std::vector<std::string> patterns;
+    std::vector<std::string> literals;   // required literal per signature ("" = none found)
+
+    // --- HOT PATH ---
+    // Feed payload bytes, continuing from `state` (0 = nothing seen yet). Returns
+    // the index of the first signature that completes, leaving `state` on the
+    // matching DFA state, or -1 once all n bytes are consumed.
+    int scan(uint16_t& state, const uint8_t* p, size_t n) const {
+        const uint16_t* t = table();
+        const uint8_t* cls = classOf;
+        const unsigned sh = shift, firstHit = firstAccept;
+        unsigned s = state;
+        for (size_t i = 0; i < n; i++) {
+            s = t[(s << sh) | cls[p[i]]];
+            if (s >= firstHit) {
+                state = uint16_t(s);
+                return accepts[s - firstHit][0];
+            }
+        }
+        state = uint16_t(s);
+        return -1;
+    }
+
+    // Same result as scan(), but the DFA only runs where the prefilter found a
+    // required literal, from maxBack bytes before its start. Exact: between
+    // packets the last maxLead bytes are always scanned, so a match whose
+    // literal lands in the next packet is already under way in `state`; and
+    // the DFA is only left again in its start state, which carries no partial
+    // match.
+    int inspect(uint16_t& state, const uint8_t* p, size_t n) const {
+        if (!filtered) return scan(state, p, n);
+        size_t i = 0;   // p[0, i) is settled: scanned or clean, with the DFA in state 0
+        if (state != 0) {
+            int hit = settle(state, p, i, n, 0);
+            if (hit >= 0 || state != 0) return hit;
+        }
+        for (;;) {
+            size_t at = prefilter.findStart(p, i, n);
+            if (at == LiteralPrefilter::NONE) {
+                // No literal left: the tail is still scanned for the next packet's sake
+                i = std::max(i, n > maxLead ? n - maxLead : 0);
+                return settle(state, p, i, n, n);
+            }
+            i = std::max(i, at > maxBack ? at - maxBack : 0);
+            int hit = settle(state, p, i, n, at + 1);
+            if (hit >= 0 || state != 0) return hit;
+        }
+    }
+
+    // Every signature that ends at `state` (empty for a non-matching state).
+    const std::vector<uint16_t>& matches(uint16_t state) const {
+        static const std::vector<uint16_t> NONE;
+        return state >= firstAccept && state < stateCount ? accepts[state - firstAccept] : NONE;
+    }
+
+    bool empty() const { return names.empty(); }
+    bool hasPrefilter() const { return filtered; }
+    const LiteralPrefilter& literalFilter() const { return prefilter; }
+    size_t dfaStates() const { return stateCount; }
+    size_t nfaStates() const { return nfaCount; }
+    size_t byteClasses() const { return classCount; }
+    size_t tableBytes() const { return lines.size() * sizeof(CacheLine); }
+
+    // --- DEFINITION COMPILER ---
+    //   sig <name> [nocase]: <regex>
+    // Blank lines and lines starting with '#' are ignored; the regex runs from
+    // after the ':' to the end of the line (surrounding blanks trimmed).
+    bool compile(const std::string& text, std::string& err);
+
+    bool loadFile(const std::string& path, std::string& err) {
+        std::ifstream f(path);
+        if (!f) { err = "Cannot open signature file: " + path; return false; }
+        std::stringstream ss;
+        ss << f.rdbuf();
+        return compile(ss.str(), err);
+    }
+
+    // Empty path = built-in signatures.
+    bool load(const std::string& path, std::string& err) {
+        return path.empty() ? compile(DEFAULT_SIGNATURES, err) : loadFile(path, err);
+    }
+
+private:
+    // Rows are a power of two of uint16_t entries, so no row straddles a line.
+    struct alignas(64) CacheLine { uint16_t next[32]; };
+
+    std::vector<CacheLine> lines;
+    uint8_t classOf[256] = {};
+    unsigned shift = 0;
+    uint16_t firstAccept = 1;                   // states >= this match something
+    uint16_t stateCount = 1;
+    size_t nfaCount = 0, classCount = 1;
+    std::vector<std::vector<uint16_t>> accepts; // per matching state, sorted signature ids
+    LiteralPrefilter prefilter;
+    bool filtered = false;                      // every signature has a required literal
+    size_t maxLead = 0;                         // furthest a literal ends past its match start
+    size_t maxBack = 0;                         // furthest a literal starts past its match start
+
+    // DFA from `state` over p[i, n), advancing i. Stops at a hit, or at the
+    // first return to the start state once i has reached `minEnd`.
+    int settle(uint16_t& state, const uint8_t* p, size_t& i, size_t n, size_t minEnd) const {
+        const uint16_t* t = table();
+        const uint8_t* cls = classOf;
+        const unsigned sh = shift, firstHit = firstAccept;
+        unsigned s = state;
+        size_t k = i;
+        int hit = -1;
+        while (k < n) {
+            s = t[(s << sh) | cls[p[k++]]];
+            if (s >= firstHit) { hit = accepts[s - firstHit][0]; break; }
+            if (s == 0 && k >= minEnd) break;
+        }
+        state = uint16_t(s);
+        i = k;
+        return hit;
+    }
+
+    const uint16_t* table() const { return lines.empty() ? nullptr : lines[0].next; }
+
+    bool build(const std::vector<bool>& nocase, std::string& err);
+};
+
+inline bool SignatureSet::compile(const std::string& text, std::string& err) {
+    *this = SignatureSet();
+    std::vector<bool> nocase;
+    std::istringstream in(text);
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        lineNo++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        size_t colon = line.find(':');
+        std::istringstream head(line.substr(0, colon));
+        std::string key, name, flag, extra;
+        head >> key >> name >> flag >> extra;
+        if (key != "sig" || colon == std::string::npos || name.empty() || !extra.empty() || (!flag.empty() && flag != "nocase")) {
+            err = "Signature line " + std::to_string(lineNo) + ": expected 'sig <name> [nocase]: <regex>'";
+            return false;
+        }
+        std::string re = line.substr(colon + 1);
+        size_t b = re.find_first_not_of(" \t"), e = re.find_last_not_of(" \t\r");
+        re = (b == std::string::npos) ? "" : re.substr(b, e - b + 1);
+        if (re.empty()) {
+            err = "Signature line " + std::to_string(lineNo) + ": empty regex";
+            return false;
+        }
+        names.push_back(name);
+        patterns.push_back(re);
+        nocase.push_back(flag == "nocase");
+    }
+    return build(nocase, err);
+}
+
+inline bool SignatureSet::build(const std::vector<bool>& nocase, std::string& err) {
+    using namespace pda_detail;
+    // 1. Thompson NFA. State 0 loops on every byte and fans out to each
+    //    signature, so a match may start at any offset of the stream.
+    std::vector<NfaState> nfa(1);
+    nfa[0].on.set();
+    nfa[0].out = 0;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        std::vector<RegexNode> nodes;
+        RegexParser parser(patterns[i], nocase[i], nodes);
+        std::string perr;
+        int root = parser.parse(perr);
+        if (root < 0) { err = "Signature '" + names[i] + "': " + perr; return false; }
+        LiteralInfo lit = requiredLiteral(nodes, root);
+        literals.push_back(lit.factor);
+        maxLead = std::max(maxLead, size_t(lit.factorEnd));
+        maxBack = std::max(maxBack, size_t(lit.factorEnd) - lit.factor.size());
+        ThompsonBuilder thompson(nodes, nfa);
+        ThompsonBuilder::Frag f = thompson.build(root);
+        nfa[f.end].accept = int(i);
+        nfa[0].eps.push_back(f.start);
+        if (nfa.size() > 1000000) { err = "Signature '" + names[i] + "': NFA too large"; return false; }
+    }
+    nfaCount = nfa.size();
+
+    // 2. Byte equivalence classes: bytes no transition tells apart share a column.
+    std::vector<int> cls(256, 0);
+    int classes = 1;
+    for (const NfaState& s : nfa) {
+        if (s.out < 0 || s.on.all()) continue;
+        std::map<std::pair<int, bool>, int> split;
+        for (int b = 0; b < 256; b++) {
+            auto it = split.emplace(std::make_pair(cls[b], bool(s.on[b])), int(split.size())).first;
+            cls[b] = it->second;
+        }
+        classes = int(split.size());
+    }
+    std::vector<int> rep(classes);
+    for (int b = 255; b >= 0; b--) rep[cls[b]] = b;
+
+    // 3. Subset construction over epsilon closures. Every subset contains
+    //    R = closure(state 0), since a match may start at any byte, and after
+    //    byte class c also the moves of R on c. Both are implied rather than
+    //    stored: a DFA state is (extra NFA states, group of R's move on the last
+    //    class), which keeps subsets small even with thousands of signatures.
+    std::vector<int> stamp(nfa.size(), -1);
+    int gen = 0;
+    auto closure = [&](std::vector<int>& set) {
+        gen++;
+        std::vector<int> todo(set);
+        set.clear();
+        while (!todo.empty()) {
+            int s = todo.back();
+            todo.pop_back();
+            if (stamp[s] == gen) continue;
+            stamp[s] = gen;
+            set.push_back(s);
+            for (int e : nfa[s].eps) todo.push_back(e);
+        }
+        std::sort(set.begin(), set.end());
+    };
+    auto move = [&](const std::vector<int>& from, int c) {
+        std::vector<int> next;
+        for (int s : from)
+            if (nfa[s].out >= 0 && nfa[s].on[rep[c]]) next.push_back(nfa[s].out);
+        closure(next);
+        return next;
+    };
+
+    std::vector<int> root{ 0 };
+    closure(root);
+    for (int s : root)
+        if (nfa[s].accept >= 0) { err = "Signature '" + names[nfa[s].accept] + "' matches the empty string"; return false; }
+    std::vector<char> inRoot(nfa.size(), 0);
+    for (int s : root) inRoot[s] = 1;
+
+    // R's move on each class, classes with the same move share a group (0 = none)
+    std::map<std::vector<int>, int> groupIds{ { {}, 0 } };
+    std::vector<std::vector<int>> groups{ {} };
+    std::vector<int> groupOf(classes);
+    for (int c = 0; c < classes; c++) {
+        std::vector<int> m = move(root, c);
+        m.erase(std::remove_if(m.begin(), m.end(), [&](int s) { return inRoot[s] != 0; }), m.end());
+        auto it = groupIds.emplace(m, int(groups.size())).first;
+        if (it->second == int(groups.size())) groups.push_back(m);
+        groupOf[c] = it->second;
+    }
+    const size_t words = (nfa.size() + 63) / 64;
+    std::vector<uint64_t> groupBits(groups.size() * words, 0);
+    for (size_t g = 0; g < groups.size(); g++)
+        for (int s : groups[g]) groupBits[g * words + size_t(s) / 64] |= uint64_t(1) << (s % 64);
+    std::vector<std::vector<int>> groupMove(groups.size() * classes);
+    std::vector<char> groupMoved(groups.size() * classes, 0);
+
+    std::map<std::vector<int>, int> ids;        // extra states + group, group last
+    std::vector<std::vector<int>> subsets(1);   // extra states
+    std::vector<int> subsetGroup(1, 0);
+    std::vector<int> trans;
+    ids[{ 0 }] = 0;
+    for (size_t d = 0; d < subsets.size(); d++) {
+        for (int c = 0; c < classes; c++) {
+            size_t gc = size_t(subsetGroup[d]) * classes + c;
+            if (!groupMoved[gc]) {
+                groupMove[gc] = move(groups[subsetGroup[d]], c);
+                groupMoved[gc] = 1;
+            }
+            std::vector<int> moved = move(subsets[d], c), key;
+            std::set_union(moved.begin(), moved.end(), groupMove[gc].begin(), groupMove[gc].end(), std::back_inserter(key));
+            int g = groupOf[c];
+            const uint64_t* implied = &groupBits[size_t(g) * words];
+            key.erase(std::remove_if(key.begin(), key.end(), [&](int s) {
+                return inRoot[s] || ((implied[s / 64] >> (s % 64)) & 1);
+            }), key.end());
+            key.push_back(g);
+            auto it = ids.find(key);
+            if (it == ids.end()) {
+                if (subsets.size() >= SIGNATURE_MAX_STATES) {
+                    err = "Signatures expand to more than " + std::to_string(SIGNATURE_MAX_STATES) + " DFA states";
+                    return false;
+                }
+                it = ids.emplace(key, int(subsets.size())).first;
+                key.pop_back();
+                subsets.push_back(key);
+                subsetGroup.push_back(g);
+            }
+            trans.push_back(it->second);
+        }
+    }
+
+    // Label = which signatures a DFA state completes (0 = none)
+    std::map<std::vector<uint16_t>, int> labelIds{ { {}, 0 } };
+    std::vector<std::vector<uint16_t>> labelSets{ {} };
+    std::vector<int> label(subsets.size());
+    for (size_t d = 0; d < subsets.size(); d++) {
+        std::vector<uint16_t> hit;
+        for (int s : subsets[d]) if (nfa[s].accept >= 0) hit.push_back(uint16_t(nfa[s].accept));
+        for (int s : groups[subsetGroup[d]]) if (nfa[s].accept >= 0) hit.push_back(uint16_t(nfa[s].accept));
+        std::sort(hit.begin(), hit.end());
+        hit.erase(std::unique(hit.begin(), hit.end()), hit.end());
+        auto it = labelIds.emplace(hit, int(labelSets.size())).first;
+        if (it->second == int(labelSets.size())) labelSets.push_back(hit);
+        label[d] = it->second;
+    }
+
+    // 4. Hopcroft, then renumber: start block first, matching blocks last so the
+    //    scan loop detects a hit with one compare.
+    int blocks = 0;
+    std::vector<int> blockOf = hopcroftMinimize(trans, classes, label, blocks);
+    std::vector<int> blockLabel(blocks);
+    for (size_t d = 0; d < subsets.size(); d++) blockLabel[blockOf[d]] = label[d];
+    std::vector<int> order{ blockOf[0] };
+    for (int pass = 0; pass < 2; pass++)
+        for (int b = 0; b < blocks; b++)
+            if (b != blockOf[0] && (blockLabel[b] != 0) == (pass == 1)) order.push_back(b);
+    std::vector<int> newId(blocks);
+    for (int i = 0; i < blocks; i++) newId[order[i]] = i;
+
+    stateCount = uint16_t(blocks);
+    classCount = size_t(classes);
+    for (int b = 0; b < 256; b++) classOf[b] = uint8_t(cls[b]);
+    while ((1u << shift) < unsigned(classes)) shift++;
+    lines.assign((size_t(blocks) << shift) / 32 + 1, CacheLine{});
+    uint16_t* t = lines[0].next;
+    firstAccept = uint16_t(blocks);
+    for (size_t d = 0; d < subsets.size(); d++) {
+        int s = newId[blockOf[d]];
+        for (int c = 0; c < classes; c++) t[(size_t(s) << shift) | c] = uint16_t(newId[blockOf[trans[d * classes + c]]]);
+        if (label[d] != 0 && s < firstAccept) firstAccept = uint16_t(s);
+    }
+    accepts.assign(blocks - firstAccept, {});
+    for (int b = 0; b < blocks; b++)
+        if (newId[b] >= firstAccept) accepts[newId[b] - firstAccept] = labelSets[blockLabel[b]];
+
+    // 5. Literal prefilter, unless some signature has no required literal
+    filtered = !literals.empty();
+    for (const std::string& lit : literals) filtered = filtered && !lit.empty();
+    if (filtered) prefilter.build(literals);
+    return true;
+}
+
+// Shared "--sigs <file>" handling for the front ends' main().
+inline std::string sigPathFromArgs(int argc, char** argv) {
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::string(argv[i]) == "--sigs") return argv[i + 1];
+    return "";
+}
@@ -0,0 +1,221 @@
+#pragma once
+// === PIPELINE SPANS ===
+// Opt-in tracing of where one packet's time goes: decode, classify, flow table
+// lookup, PDA transition, signature scan and emit (hooks handing results out),
+// nested under one "packet" span per packet. Every thread records into its own
+// SpanRing, 16 bytes per span stamped with the CPU's time-stamp counter (rdtsc;
+// steady_clock nanoseconds where there is none), so tracing takes no lock and
+// makes no system call. With tracing off a stage costs one null-pointer test.
+//
+// A ring keeps the newest spans and overwrites the oldest. With a threshold,
+// a top-level span shorter than it is rolled back together with everything
+// nested in it, so the ring holds only the slow packets: the tail latency
+// spikes, each with its full breakdown.
+//
+// SpanTracer owns the rings and exports them as Chrome trace-event JSON (load
+// in chrome://tracing or Perfetto) and as folded stacks ("thread;packet;
+// transition;signature <ns>") for flamegraph.pl / speedscope, self time only.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+inline uint64_t readTsc() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+enum SpanStage : uint8_t { SPAN_DECODE, SPAN_CLASSIFY, SPAN_LOOKUP, SPAN_TRANSITION, SPAN_SIGNATURE, SPAN_EMIT, SPAN_PACKET, SPAN_STAGES };
+
+inline const char* spanStageName(uint8_t s) {
+    static const char* const NAMES[SPAN_STAGES] = { "decode", "classify", "lookup", "transition", "signature", "emit", "packet" };
+    return s < SPAN_STAGES ? NAMES[s] : "?";
+}
+
+struct Span {
+    uint64_t begin;   // tsc
+    uint32_t ticks;   // duration, saturated
+    uint8_t  stage;   // SpanStage
+    uint8_t  depth;   // 0 = top level
+    uint16_t pad;
+};
+static_assert(sizeof(Span) == 16, "spans are 16 bytes");
+
+// === PER-THREAD RING ===
+class SpanRing {
+public:
+    SpanRing(std::string name, size_t capacityPow2, uint64_t minTicks)
+        : name(std::move(name)), spans(capacityPow2), mask(capacityPow2 - 1), minTicks(minTicks) {}
+
+    // --- HOT PATH --- the owning thread only
+    // Position to roll back to if the top-level span starting now is too short.
+    size_t mark() const { return head; }
+
+    void add(SpanStage stage, uint64_t t0, uint64_t t1, uint8_t depth) {
+        uint64_t d = t1 - t0;
+        spans[head & mask] = Span{ t0, d > 0xFFFFFFFFu ? 0xFFFFFFFFu : uint32_t(d), stage, depth, 0 };
+        head++;
+    }
+
+    // A top-level span: kept with its children, or dropped with them when it
+    // is under the threshold.
+    void top(SpanStage stage, uint64_t t0, uint64_t t1, size_t from) {
+        if (t1 - t0 < minTicks) {
+            head = from;
+            return;
+        }
+        add(stage, t0, t1, 0);
+    }
+
+    // --- READERS --- once the thread is done
+    const std::string& threadName() const { return name; }
+    uint64_t recorded() const { return head; }
+
+    // Oldest first, in end order (children before their parent).
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        size_t from = head > spans.size() ? head - spans.size() : 0;
+        for (size_t i = from; i < head; i++) fn(spans[i & mask]);
+    }
+
+private:
+    std::string name;
+    std::vector<Span> spans;
+    size_t mask;
+    size_t head = 0;
+    uint64_t minTicks;
+};
+
+// === TRACER ===
+class SpanTracer {
+public:
+    // capacity: spans kept per thread; minNanos: top-level spans shorter than
+    // this are not kept (0 = keep all).
+    explicit SpanTracer(size_t capacity = 1 << 18, uint64_t minNanos = 0) {
+        size_t cap = 1024;
+        while (cap < capacity) cap <<= 1;
+        ringSize = cap;
+        // A first estimate of the counter rate for the threshold; export uses the whole run.
+        startTsc = readTsc();
+        startNs = nowNs();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        minTicks = uint64_t(double(minNanos) * ticksPerNs());
+    }
+
+    // One ring per recording thread, created before the thread starts.
+    SpanRing* thread(const std::string& name) {
+        rings.emplace_back(new SpanRing(name, ringSize, minTicks));
+        return rings.back().get();
+    }
+
+    uint64_t recorded() const {
+        uint64_t n = 0;
+        for (const auto& r : rings) n += r->recorded();
+        return n;
+    }
+
+    // Chrome trace-event JSON: one complete ("X") event per span, µs since start.
+    bool writeChrome(const std::string& path, std::string& err) const {
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) {
+            err = "cannot write " + path;
+            return false;
+        }
+        double perUs = ticksPerNs() * 1000.0;
+        std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", f);
+        bool first = true;
+        for (size_t t = 0; t < rings.size(); t++) {
+            std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                         first ? "" : ",\n", t, rings[t]->threadName().c_str());
+            first = false;
+            rings[t]->forEach([&](const Span& s) {
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"pda\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+                             spanStageName(s.stage), t, double(s.begin - startTsc) / perUs, double(s.ticks) / perUs);
+            });
+        }
+        std::fputs("\n]}\n", f);
+        if (std::fclose(f) != 0) {
+            err = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    // Folded stacks, self time in ns: "worker 0;packet;transition 12345".
+    bool writeFolded(const std::string& path, std::string& err) const {
+        std::map<std::string, double> self;
+        double perNs = ticksPerNs();
+        for (const auto& r : rings) {
+            // Newest first, a parent comes before its children; the open
+            // ancestors are a stack indexed by depth.
+            std::vector<Span> all;
+            r->forEach([&](const Span& s) { all.push_back(s); });
+            std::vector<std::string> stack{ r->threadName() };
+            std::vector<const Span*> open;
+            for (size_t i = all.size(); i-- > 0;) {
+                const Span& s = all[i];
+                while (!open.empty() && (open.size() > s.depth || s.begin < open.back()->begin)) {
+                    open.pop_back();
+                    stack.pop_back();
+                }
+                if (open.size() != s.depth) continue;   // its parent was overwritten
+                std::string parent = stack.size() > 1 ? join(stack) : "";
+                stack.push_back(spanStageName(s.stage));
+                open.push_back(&s);
+                double ns = double(s.ticks) / perNs;
+                self[join(stack)] += ns;
+                if (!parent.empty()) self[parent] -= ns;
+            }
+        }
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) {
+            err = "cannot write " + path;
+            return false;
+        }
+        for (const auto& e : self)
+            if (e.second >= 0.5) std::fprintf(f, "%s %.0f\n", e.first.c_str(), e.second);
+        if (std::fclose(f) != 0) {
+            err = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    // Counter ticks per nanosecond, measured from construction to now.
+    double ticksPerNs() const {
+        uint64_t ns = nowNs() - startNs;
+        return ns ? double(readTsc() - startTsc) / double(ns) : 1.0;
+    }
+
+private:
+    std::vector<std::unique_ptr<SpanRing>> rings;
+    size_t ringSize;
+    uint64_t minTicks = 0;
+    uint64_t startTsc;
+    uint64_t startNs;
+
+    static uint64_t nowNs() {
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static std::string join(const std::vector<std::string>& parts) {
+        std::string s;
+        for (size_t i = 0; i < parts.size(); i++) s += (i ? ";" : "") + parts[i];
+        return s;
+    }
+};
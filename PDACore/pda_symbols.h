@@ -0,0 +1,126 @@
+#pragma once
+// === PACKET SYMBOL ALPHABET ===
+// Packet labels ("SYN", "HTTP_GET", "ROOT_CMD", ...) are classified ONCE into a
+// small integer alphabet. The PDA never compares strings after this point.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Input symbols (Sigma). Every label that is not a TCP control packet is
+// payload, because the q1 tunnel is payload agnostic. Each symbol exists once
+// per direction: as sent by the side that opened the connection (the
+// initiator) and as sent by the responder. Text labels are the initiator's
+// unless they end in '<'; a trailing '>' spells the initiator side explicitly,
+// as in definition files.
+enum Symbol : uint8_t {
+    SYM_SYN,
+    SYM_SYN_ACK,
+    SYM_ACK,
+    SYM_FIN,
+    SYM_RST,
+    SYM_DATA,
+    SYM_R_SYN,          // the same six, responder -> initiator
+    SYM_R_SYN_ACK,
+    SYM_R_ACK,
+    SYM_R_FIN,
+    SYM_R_RST,
+    SYM_R_DATA,
+    SYM_INVALID,        // a flag combination no TCP stack sends (pda_tcp.h)
+    SYM_COUNT
+};
+
+constexpr int SYM_DIRECTED = SYM_R_SYN;   // responder copy = initiator symbol + this
+
+inline const char* symbolName(Symbol s) {
+    static const char* const NAMES[SYM_COUNT] = { "SYN",  "SYN_ACK",  "ACK",  "FIN",  "RST",  "DATA",
+                                                  "SYN<", "SYN_ACK<", "ACK<", "FIN<", "RST<", "DATA<",
+                                                  "INVALID" };
+    return s < SYM_COUNT ? NAMES[s] : "?";
+}
+
+inline bool isResponder(Symbol s) { return s >= SYM_DIRECTED && s < SYM_INVALID; }
+
+// Direction dropped: SYM_R_DATA -> SYM_DATA.
+inline Symbol undirected(Symbol s) { return isResponder(s) ? Symbol(s - SYM_DIRECTED) : s; }
+
+// Name -> set of IDs (bit i = symbol i) for definition files (cold path). A bare
+// name ("SYN") covers both directions, "SYN>" only the initiator's and "SYN<"
+// only the responder's. 0 if not in the alphabet.
+inline uint32_t symbolMask(std::string_view name) {
+    if (name == symbolName(SYM_INVALID)) return 1u << SYM_INVALID;
+    char dir = name.empty() ? 0 : name.back();
+    if (dir == '<' || dir == '>') name.remove_suffix(1);
+    for (int i = 0; i < SYM_DIRECTED; i++) {
+        if (name != symbolName(Symbol(i))) continue;
+        uint32_t mask = 0;
+        if (dir != '<') mask |= 1u << i;
+        if (dir != '>') mask |= 1u << (i + SYM_DIRECTED);
+        return mask;
+    }
+    return 0;
+}
+
+// === PERFECT HASH CLASSIFIER ===
+// The control keywords land in distinct buckets of an 8-slot table using only the
+// first byte, the last byte and nothing else. A label is therefore classified with
+// one hash, one length check and one memcmp; misses fall through to SYM_DATA.
+namespace pda_detail {
+
+constexpr unsigned KEYWORD_SLOTS = 8;
+
+constexpr unsigned keywordHash(const char* s, size_t len) {
+    return (unsigned(uint8_t(s[0])) + (unsigned(uint8_t(s[len - 1])) << 2)) & (KEYWORD_SLOTS - 1);
+}
+
+struct Keyword {
+    const char* text;
+    uint8_t len;
+    Symbol sym;
+};
+
+constexpr Keyword KEYWORDS[] = {
+    { "SYN",     3, SYM_SYN     },
+    { "SYN_ACK", 7, SYM_SYN_ACK },
+    { "ACK",     3, SYM_ACK     },
+    { "FIN",     3, SYM_FIN     },
+    { "RST",     3, SYM_RST     },
+};
+
+struct KeywordTable {
+    Keyword slot[KEYWORD_SLOTS];
+};
+
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable t{};
+    for (unsigned i = 0; i < KEYWORD_SLOTS; i++) t.slot[i] = { "", 0, SYM_DATA };
+    for (const Keyword& k : KEYWORDS) t.slot[keywordHash(k.text, k.len)] = k;
+    return t;
+}
+
+constexpr bool keywordHashIsPerfect() {
+    for (size_t i = 0; i < sizeof(KEYWORDS) / sizeof(KEYWORDS[0]); i++)
+        for (size_t j = i + 1; j < sizeof(KEYWORDS) / sizeof(KEYWORDS[0]); j++)
+            if (keywordHash(KEYWORDS[i].text, KEYWORDS[i].len) == keywordHash(KEYWORDS[j].text, KEYWORDS[j].len))
+                return false;
+    return true;
+}
+
+static_assert(keywordHashIsPerfect(), "keyword hash has a collision: pick new shift/mask");
+
+constexpr KeywordTable KEYWORD_TABLE = buildKeywordTable();
+
+} // namespace pda_detail
+
+inline Symbol classifyPacket(std::string_view label) {
+    int dir = 0;
+    if (!label.empty() && (label.back() == '<' || label.back() == '>')) {
+        if (label.back() == '<') dir = SYM_DIRECTED;
+        label.remove_suffix(1);
+    }
+    if (label.empty()) return Symbol(SYM_DATA + dir);
+    const pda_detail::Keyword& k = pda_detail::KEYWORD_TABLE.slot[pda_detail::keywordHash(label.data(), label.size())];
+    if (k.len == label.size() && std::memcmp(k.text, label.data(), k.len) == 0) return Symbol(k.sym + dir);
+    return Symbol(SYM_DATA + dir);
+}
@@ -0,0 +1,122 @@
+#pragma once
+// === TCP SEGMENTS -> PDA INPUTS ===
+// Captured segments are classified straight from the raw TCP flags byte: one
+// lookup in a table indexed by [direction][payload present][flags], built at
+// compile time, gives the directed input symbol. No branches, no strings.
+// Direction is relative to the flow's initiator (the side whose packet opened
+// the flow), so the same table serves every connection.
+
+#include <cstdint>
+#include "pda_symbols.h"
+
+enum TcpFlag : uint8_t {
+    TCP_FIN = 0x01, TCP_SYN = 0x02, TCP_RST = 0x04, TCP_PSH = 0x08,
+    TCP_ACK = 0x10, TCP_URG = 0x20, TCP_ECE = 0x40, TCP_CWR = 0x80
+};
+
+namespace pda_detail {
+
+// Control bits first (RST, SYN, SYN+ACK, FIN), then payload presence. Combos no
+// stack sends are INVALID: SYN with FIN or RST, and (RFC 793) any segment but
+// the first SYN or a RST without ACK, which covers null, FIN and XMAS scans.
+constexpr Symbol tcpSymbolOf(unsigned flags, bool payload) {
+    if ((flags & TCP_SYN) && (flags & (TCP_FIN | TCP_RST))) return SYM_INVALID;
+    if (flags & TCP_RST) return SYM_RST;
+    if (flags & TCP_SYN) return (flags & TCP_ACK) ? SYM_SYN_ACK : SYM_SYN;
+    if (!(flags & TCP_ACK)) return SYM_INVALID;
+    if (flags & TCP_FIN) return SYM_FIN;
+    return payload ? SYM_DATA : SYM_ACK;
+}
+
+struct TcpInputTable {
+    Symbol sym[2][2][256];   // [from responder][payload][flags]
+};
+
+constexpr TcpInputTable buildTcpInputTable() {
+    TcpInputTable t{};
+    for (unsigned f = 0; f < 256; f++)
+        for (int p = 0; p < 2; p++) {
+            Symbol s = tcpSymbolOf(f, p != 0);
+            t.sym[0][p][f] = s;
+            t.sym[1][p][f] = s == SYM_INVALID ? s : Symbol(s + SYM_DIRECTED);
+        }
+    return t;
+}
+
+constexpr TcpInputTable TCP_INPUT_TABLE = buildTcpInputTable();
+
+} // namespace pda_detail
+
+inline Symbol tcpInput(uint8_t flags, bool payload, bool fromResponder) {
+    return pda_detail::TCP_INPUT_TABLE.sym[fromResponder][payload][flags];
+}
+
+// RFC 793 processes a segment's text before its FIN bit, so a FIN that carries
+// data is two inputs from the same side: DATA, then the FIN. Stepped as a bare
+// FIN, data sent after close would pass as teardown in TIME_WAIT and CLOSING
+// and skip the signature scan. True, with the DATA input in `data`, for such a
+// segment; `sym` is its tcpInput().
+inline bool tcpSplitFin(Symbol sym, bool payload, Symbol& data) {
+    if (!payload || undirected(sym) != SYM_FIN) return false;
+    data = Symbol(sym - SYM_FIN + SYM_DATA);
+    return true;
+}
+
+// === BUILT-IN CONNECTION PROTOCOL (RFC 793) ===
+// Same text as PDACore/protocols/tcp_rfc793.pda. The default for captures,
+// where both directions of every conversation are on the wire.
+const char* const TCP_RFC793_PDA = R"PDA(
+pda      tcp_rfc793
+states   LISTEN SYN_SENT SYN_RCVD ESTABLISHED FIN_WAIT CLOSE_WAIT CLOSING TIME_WAIT CLOSED TRAP
+start    LISTEN
+accept   TIME_WAIT CLOSED
+trap     TRAP
+inspect  SYN_RCVD ESTABLISHED FIN_WAIT CLOSE_WAIT
+handshake SYN_SENT SYN_RCVD
+inputs   SYN SYN_ACK ACK FIN RST DATA
+stack    Z0 SESSION
+bottom   Z0
+
+rule no_handshake:  LISTEN      *        *       -> TRAP
+rule handshake:     LISTEN      SYN>     *       -> SYN_SENT push SESSION
+rule hijack:        SYN_SENT    *        *       -> TRAP
+rule syn_retry:     SYN_SENT    SYN>     SESSION -> SYN_SENT
+rule syn_ack:       SYN_SENT    SYN_ACK< SESSION -> SYN_RCVD
+rule simultaneous:  SYN_SENT    SYN<     SESSION -> SYN_RCVD
+rule refused:       SYN_SENT    RST<     SESSION -> CLOSED pop
+rule hijack:        SYN_RCVD    *        *       -> TRAP
+rule syn_ack:       SYN_RCVD    SYN_ACK  SESSION -> SYN_RCVD
+rule established:   SYN_RCVD    ACK      SESSION -> ESTABLISHED
+rule established:   SYN_RCVD    DATA>    SESSION -> ESTABLISHED
+rule reset:         SYN_RCVD    RST      SESSION -> CLOSED pop
+rule hijack:        ESTABLISHED *        *       -> TRAP
+rule tunnel:        ESTABLISHED ACK      SESSION -> ESTABLISHED
+rule tunnel:        ESTABLISHED DATA     SESSION -> ESTABLISHED
+rule active_close:  ESTABLISHED FIN>     SESSION -> FIN_WAIT
+rule passive_close: ESTABLISHED FIN<     SESSION -> CLOSE_WAIT
+rule reset:         ESTABLISHED RST      SESSION -> CLOSED pop
+rule after_close:   FIN_WAIT    *        *       -> TRAP
+rule half_close:    FIN_WAIT    ACK      SESSION -> FIN_WAIT
+rule half_close:    FIN_WAIT    DATA<    SESSION -> FIN_WAIT
+rule half_close:    FIN_WAIT    FIN>     SESSION -> FIN_WAIT
+rule close:         FIN_WAIT    FIN<     SESSION -> CLOSING
+rule reset:         FIN_WAIT    RST      SESSION -> CLOSED pop
+rule after_close:   CLOSE_WAIT  *        *       -> TRAP
+rule half_close:    CLOSE_WAIT  ACK      SESSION -> CLOSE_WAIT
+rule half_close:    CLOSE_WAIT  DATA>    SESSION -> CLOSE_WAIT
+rule half_close:    CLOSE_WAIT  FIN<     SESSION -> CLOSE_WAIT
+rule close:         CLOSE_WAIT  FIN>     SESSION -> CLOSING
+rule reset:         CLOSE_WAIT  RST      SESSION -> CLOSED pop
+rule after_close:   CLOSING     *        *       -> TRAP
+rule close:         CLOSING     FIN      SESSION -> CLOSING
+rule last_ack:      CLOSING     ACK      SESSION -> TIME_WAIT pop
+rule reset:         CLOSING     RST      SESSION -> CLOSED pop
+rule after_close:   TIME_WAIT   *        *       -> TRAP
+rule teardown:      TIME_WAIT   ACK      *       -> TIME_WAIT
+rule teardown:      TIME_WAIT   FIN      *       -> TIME_WAIT
+rule teardown:      TIME_WAIT   RST      *       -> TIME_WAIT
+rule after_close:   CLOSED      *        *       -> TRAP
+rule teardown:      CLOSED      ACK      *       -> CLOSED
+rule teardown:      CLOSED      RST      *       -> CLOSED
+rule blocked:       TRAP        *        *       -> TRAP
+)PDA";
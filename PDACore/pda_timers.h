@@ -0,0 +1,186 @@
+#pragma once
+// === HIERARCHICAL TIMER WHEEL ===
+// Per-flow timeouts for the session table (Varghese & Lauck). LEVELS wheels of
+// 64 buckets; level l files timers due 64^l .. 64^(l+1) ticks ahead, and when
+// level l-1 wraps, the due bucket of level l is re-filed one level down. Timers
+// are nodes of one pool, doubly linked by index inside their bucket, so insert
+// and cancel are O(1) and expiry is O(1) per timer plus at most LEVELS - 1
+// cascades. A 64-bit occupancy mask per level lets advance() jump straight to
+// the next bucket with work, so long quiet gaps in a capture cost nothing.
+//
+// Re-arming is lazy: touch() with a later deadline only rewrites the node, and
+// a timer whose bucket comes due with its deadline still ahead is filed again
+// instead of fired. A packet therefore costs one store, not an unlink + link.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class TimerWheel {
+public:
+    static constexpr uint32_t NIL = 0xFFFFFFFFu;
+    static constexpr int BITS = 6;
+    static constexpr int SLOTS = 1 << BITS;
+    static constexpr int LEVELS = 4;
+    static constexpr uint64_t SPAN = uint64_t(1) << (BITS * LEVELS);   // farthest deadline filed as is
+
+    explicit TimerWheel(uint64_t startTick = 0) : current(startTick) {
+        for (uint32_t& h : heads) h = NIL;
+    }
+
+    uint64_t now() const { return current; }
+    size_t size() const { return active; }
+    size_t memoryBytes() const { return nodes.capacity() * sizeof(Node); }
+
+    // New timer firing at tick deadline; tag comes back to the expiry callback.
+    uint32_t add(uint64_t deadline, uint32_t tag) {
+        uint32_t id = freeList;
+        if (id == NIL) {
+            id = uint32_t(nodes.size());
+            nodes.emplace_back();
+        } else {
+            freeList = nodes[id].next;
+        }
+        nodes[id].deadline = deadline;
+        nodes[id].tag = tag;
+        file(id);
+        active++;
+        return id;
+    }
+
+    void cancel(uint32_t id) {
+        unlink(id);
+        release(id);
+        active--;
+    }
+
+    // Move a timer's deadline. Later is a plain store; earlier than the bucket
+    // it waits in means re-filing it.
+    void touch(uint32_t id, uint64_t deadline) {
+        Node& n = nodes[id];
+        n.deadline = deadline;
+        if (deadline < n.filed) {
+            unlink(id);
+            file(id);
+        }
+    }
+
+    // Run the clock up to tick `to`, calling fn(id, tag) for every timer whose
+    // deadline passed. The timer is already released when fn runs; fn may add
+    // new timers. A clock running backwards is ignored.
+    template <typename Fn>
+    void advance(uint64_t to, Fn&& fn) {
+        while (current < to) {
+            uint64_t next = active ? nextBusyTick() : to + 1;
+            if (next > to) {
+                current = to;
+                break;
+            }
+            current = next;
+            if ((current & (SLOTS - 1)) == 0) cascade(1);
+            expire(unsigned(current & (SLOTS - 1)), fn);
+        }
+    }
+
+private:
+    struct Node {
+        uint64_t deadline;   // tick the timer is due (moved by touch)
+        uint64_t filed;      // deadline it was filed under (SPAN-clamped)
+        uint32_t next;       // bucket list / free list
+        uint32_t prev;
+        uint32_t tag;
+        uint16_t bucket;     // level * SLOTS + slot
+    };
+
+    std::vector<Node> nodes;
+    uint32_t freeList = NIL;
+    uint32_t heads[LEVELS * SLOTS];
+    uint64_t occupied[LEVELS] = {};
+    uint64_t current;
+    size_t active = 0;
+
+    // Level l's bucket s is handled when digit l of the clock turns to s with
+    // every lower digit zero; the earliest such tick over the occupied buckets.
+    uint64_t nextBusyTick() const {
+        uint64_t best = ~uint64_t(0);
+        for (int level = 0; level < LEVELS; level++) {
+            uint64_t occ = occupied[level];
+            if (!occ) continue;
+            int shift = BITS * level;
+            unsigned r = unsigned((current >> shift) + 1) & (SLOTS - 1);
+            uint64_t rot = r ? (occ >> r) | (occ << (SLOTS - r)) : occ;   // bucket of digit + 1 at bit 0
+            uint64_t t = ((current >> shift) + uint64_t(__builtin_ctzll(rot)) + 1) << shift;
+            if (t < best) best = t;
+        }
+        return best;
+    }
+
+    // Ticks up to current have fired, so a due timer goes to the next one;
+    // a cascade runs before its tick fires and may file into that tick.
+    void file(uint32_t id, bool cascading = false) {
+        Node& n = nodes[id];
+        uint64_t earliest = cascading ? current : current + 1;
+        uint64_t d = n.deadline > earliest ? n.deadline : earliest;
+        if (d - current >= SPAN) d = current + SPAN - 1;
+        uint64_t delta = d - current;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (uint64_t(1) << (BITS * (level + 1)))) level++;
+        unsigned slot = unsigned(d >> (BITS * level)) & (SLOTS - 1);
+        unsigned b = unsigned(level) * SLOTS + slot;
+        n.filed = d;
+        n.bucket = uint16_t(b);
+        n.prev = NIL;
+        n.next = heads[b];
+        if (n.next != NIL) nodes[n.next].prev = id;
+        heads[b] = id;
+        occupied[level] |= uint64_t(1) << slot;
+    }
+
+    void unlink(uint32_t id) {
+        Node& n = nodes[id];
+        if (n.prev != NIL) nodes[n.prev].next = n.next;
+        else heads[n.bucket] = n.next;
+        if (n.next != NIL) nodes[n.next].prev = n.prev;
+        if (heads[n.bucket] == NIL) occupied[n.bucket / SLOTS] &= ~(uint64_t(1) << (n.bucket % SLOTS));
+    }
+
+    void release(uint32_t id) {
+        nodes[id].next = freeList;
+        freeList = id;
+    }
+
+    uint32_t detach(unsigned b) {
+        uint32_t id = heads[b];
+        heads[b] = NIL;
+        occupied[b / SLOTS] &= ~(uint64_t(1) << (b % SLOTS));
+        return id;
+    }
+
+    // Level l's bucket for the current tick moves down; a wrap of l moves l + 1 too.
+    void cascade(int level) {
+        if (level >= LEVELS) return;
+        unsigned slot = unsigned(current >> (BITS * level)) & (SLOTS - 1);
+        for (uint32_t id = detach(unsigned(level) * SLOTS + slot); id != NIL;) {
+            uint32_t next = nodes[id].next;
+            file(id, true);
+            id = next;
+        }
+        if (slot == 0) cascade(level + 1);
+    }
+
+    template <typename Fn>
+    void expire(unsigned slot, Fn& fn) {
+        for (uint32_t id = detach(slot); id != NIL;) {
+            uint32_t next = nodes[id].next;
+            if (nodes[id].deadline > current) {
+                file(id);      // touched since it was filed: re-arm
+            } else {
+                uint32_t tag = nodes[id].tag;
+                release(id);
+                active--;
+                fn(id, tag);
+            }
+            id = next;
+        }
+    }
+};
@@ -0,0 +1,352 @@
+#pragma once
+// === PDA STEP TRACE (.pdatrace) ===
+// Every step of every flow, written once (by the CaptureValidator, or by a
+// visualizer for its built-in scenarios) and read in place by the front ends.
+// The file is columnar: one array per field, flows stored back to back, so a
+// reader maps it and indexes the arrays directly. Nothing is parsed or copied.
+//
+//   header             64 bytes
+//   flowStart          uint64[flows + 1]   flow f's steps are [flowStart[f], flowStart[f + 1])
+//   flowName           uint32[flows]       string ids
+//   depth              uint16[steps]       stack depth after the step
+//   label              uint32[steps]       string id of the packet label
+//   stringStart        uint32[strings + 1] string i is text[stringStart[i] .. stringStart[i + 1])
+//   flowVerdict        uint8[flows]        Verdict after the flow's last step
+//   state              uint8[steps]        state after the step
+//   symbol             uint8[steps]        input Symbol
+//   rule               uint8[steps]        definition rule that fired
+//   flags              uint8[steps]        TraceFlag bits
+//   top                uint8[steps]        stack top after the step (a stack symbol id)
+//   text               char[stringBytes]
+//
+// Every array starts on an 8-byte boundary. The string table is dictionary
+// encoded (each distinct label or name stored once) and begins with the
+// definition's names: state ids, stack symbol ids and rule ids are string ids
+// once offset by the counts in the header, so a trace explains itself.
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "pda_capture.h"
+
+const char TRACE_MAGIC[8] = { 'P', 'D', 'A', 'T', 'R', 'A', 'C', '1' };
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t strings;
+    uint64_t flows;
+    uint64_t steps;
+    uint64_t stringBytes;
+    uint8_t states;             // string ids 0.. are the state names,
+    uint8_t stackSymbols;       // then the stack symbol names,
+    uint8_t rules;              // then the rule names, then labels and flow names
+    uint8_t start;              // configuration before a flow's first step
+    uint8_t bottom;
+    uint8_t trap;
+    uint8_t reserved[18];
+};
+static_assert(sizeof(TraceHeader) == 64, "trace header is 64 bytes on disk");
+
+enum TraceFlag : uint8_t {
+    TRACE_PUSH = 0x01,
+    TRACE_POP = 0x02,
+    TRACE_ATTACK = 0x04,        // this step sent the flow to the trap
+    TRACE_SIGNATURE = 0x08,     // ... because its payload matched a signature
+    TRACE_OVERFLOW = 0x10,      // ... because a push did not fit the stack
+    TRACE_BLOCKED = 0x20,       // the flow was already trapped
+};
+
+// Section offsets, computed from the counts alone.
+struct TraceLayout {
+    uint64_t flowStart, flowName, depth, label, stringStart, flowVerdict;
+    uint64_t state, symbol, rule, flags, top, text, end;
+
+    explicit TraceLayout(const TraceHeader& h) {
+        uint64_t at = sizeof(TraceHeader);
+        auto section = [&](uint64_t bytes) {
+            uint64_t here = at;
+            at = (at + bytes + 7) & ~uint64_t(7);
+            return here;
+        };
+        flowStart = section((h.flows + 1) * 8);
+        flowName = section(h.flows * 4);
+        depth = section(h.steps * 2);
+        label = section(h.steps * 4);
+        stringStart = section((uint64_t(h.strings) + 1) * 4);
+        flowVerdict = section(h.flows);
+        state = section(h.steps);
+        symbol = section(h.steps);
+        rule = section(h.steps);
+        flags = section(h.steps);
+        top = section(h.steps);
+        text = section(h.stringBytes);
+        end = at;
+    }
+};
+
+// === WRITER ===
+// Steps arrive in packet order, flows interleaved; write() groups them by flow
+// with one counting pass. Buffers a 16-byte Row per step until then, plus a
+// 4-byte index per step while writing; on disk a step takes 11 bytes.
+class TraceWriter {
+public:
+    explicit TraceWriter(const PdaTable& protocol) : protocol(protocol) {
+        for (const std::string& s : protocol.states) intern(s, true);
+        for (const std::string& s : protocol.stackSyms) intern(s, true);
+        for (const std::string& s : protocol.rules) intern(s, true);
+    }
+
+    uint32_t addFlow(std::string_view name) {
+        flowNames.push_back(intern(name));
+        PdaConfig c;
+        protocol.reset(c);
+        flowVerdicts.push_back(protocol.verdict(c));
+        counts.push_back(0);
+        return uint32_t(flowNames.size() - 1);
+    }
+
+    // One step of `flow`: the transition taken and the configuration it left.
+    void step(uint32_t flow, Symbol sym, const PdaTransition& t, const PdaConfig& after, uint8_t flags,
+              std::string_view label) {
+        if (t.delta > 0) flags |= TRACE_PUSH;
+        if (t.delta < 0) flags |= TRACE_POP;
+        if (after.overflow && !(flags & TRACE_BLOCKED)) flags |= TRACE_OVERFLOW | TRACE_ATTACK;
+        rows.push_back(Row{ flow, intern(label), uint16_t(after.depth()), after.state, uint8_t(sym), t.rule, flags,
+                            protocol.top(after) });
+        flowVerdicts[flow] = protocol.verdict(after);
+        counts[flow]++;
+    }
+
+    size_t flows() const { return flowNames.size(); }
+    size_t steps() const { return rows.size(); }
+
+    void write(std::ostream& out) const {
+        TraceHeader h{};
+        std::memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+        h.version = TRACE_VERSION;
+        h.strings = uint32_t(strings());
+        h.flows = flowNames.size();
+        h.steps = rows.size();
+        h.stringBytes = text.size();
+        h.states = uint8_t(protocol.states.size());
+        h.stackSymbols = uint8_t(protocol.stackSyms.size());
+        h.rules = uint8_t(protocol.rules.size());
+        h.start = protocol.start;
+        h.bottom = protocol.bottom;
+        h.trap = protocol.trap;
+        TraceLayout l(h);
+
+        // Row i goes to position order[i] of its flow's run
+        std::vector<uint64_t> start(flowNames.size() + 1, 0);
+        for (size_t f = 0; f < counts.size(); f++) start[f + 1] = start[f] + counts[f];
+        std::vector<uint64_t> next(start.begin(), start.end() - 1);
+        std::vector<uint32_t> order(rows.size());
+        for (size_t i = 0; i < rows.size(); i++) order[next[rows[i].flow]++] = uint32_t(i);
+
+        uint64_t at = 0;
+        auto put = [&](uint64_t offset, const void* p, size_t n) {
+            static const char PAD[8] = {};
+            out.write(PAD, std::streamsize(offset - at));
+            out.write(static_cast<const char*>(p), std::streamsize(n));
+            at = offset + n;
+        };
+        // Columns go out in blocks so a trace of any size needs no second copy
+        auto column = [&](uint64_t offset, auto field) {
+            using T = decltype(field(rows[0]));
+            T buf[4096];
+            size_t n = 0;
+            for (uint32_t i : order) {
+                buf[n++] = field(rows[i]);
+                if (n == 4096) {
+                    put(offset, buf, sizeof(buf));
+                    offset += sizeof(buf);
+                    n = 0;
+                }
+            }
+            put(offset, buf, n * sizeof(T));
+        };
+
+        put(0, &h, sizeof(h));
+        put(l.flowStart, start.data(), start.size() * 8);
+        put(l.flowName, flowNames.data(), flowNames.size() * 4);
+        if (!rows.empty()) {
+            column(l.depth, [](const Row& r) { return r.depth; });
+            column(l.label, [](const Row& r) { return r.label; });
+        }
+        put(l.stringStart, stringStart.data(), stringStart.size() * 4);
+        put(l.flowVerdict, flowVerdicts.data(), flowVerdicts.size());
+        if (!rows.empty()) {
+            column(l.state, [](const Row& r) { return r.state; });
+            column(l.symbol, [](const Row& r) { return r.sym; });
+            column(l.rule, [](const Row& r) { return r.rule; });
+            column(l.flags, [](const Row& r) { return r.flags; });
+            column(l.top, [](const Row& r) { return r.top; });
+        }
+        put(l.text, text.data(), text.size());
+        put(l.end, nullptr, 0);
+    }
+
+    bool save(const std::string& path, std::string& err) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) { err = "Cannot write " + path; return false; }
+        write(out);
+        if (!out.flush()) { err = "Write failed: " + path; return false; }
+        return true;
+    }
+
+private:
+    struct Row {
+        uint32_t flow;
+        uint32_t label;
+        uint16_t depth;
+        uint8_t state, sym, rule, flags, top;
+    };
+
+    const PdaTable& protocol;
+    std::vector<Row> rows;
+    std::vector<uint32_t> flowNames;
+    std::vector<uint8_t> flowVerdicts;
+    std::vector<uint64_t> counts;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<uint32_t> stringStart{ 0 };
+    std::string text;
+
+    size_t strings() const { return stringStart.size() - 1; }
+
+    // The definition's names keep their positions even when two are equal.
+    uint32_t intern(std::string_view s, bool always = false) {
+        if (!always) {
+            auto it = ids.find(std::string(s));
+            if (it != ids.end()) return it->second;
+        }
+        uint32_t id = uint32_t(strings());
+        ids.emplace(std::string(s), id);
+        text.append(s.data(), s.size());
+        stringStart.push_back(uint32_t(text.size()));
+        return id;
+    }
+};
+
+// === READER ===
+// A trace mapped from disk (open) or any 8-byte aligned buffer (view). The
+// accessors index straight into it, so view() checks once that every index
+// the file holds (flow offsets, string ids, states, rules) stays inside it;
+// a corrupt or hostile file is refused rather than read out of bounds.
+struct TraceFrame {
+    uint8_t state;
+    uint8_t top;
+    uint16_t depth;
+};
+
+class TraceFile {
+public:
+    bool open(const std::string& path, std::string& err) {
+        if (!file.open(path, err)) return false;
+        return view(file.data(), file.size(), err);
+    }
+
+    bool view(const uint8_t* data, size_t size, std::string& err) {
+        if (size < sizeof(TraceHeader) || std::memcmp(data, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0) {
+            err = "Not a PDA trace";
+            return false;
+        }
+        std::memcpy(&h, data, sizeof(h));
+        if (h.version != TRACE_VERSION) { err = "Unsupported trace version"; return false; }
+        if (reinterpret_cast<uintptr_t>(data) % 8) { err = "Trace buffer is not 8-byte aligned"; return false; }
+        // Bounded by the size first, so the layout arithmetic cannot overflow
+        if (h.flows >= size / 8 || h.steps > size / 2 || h.strings >= size / 4 || h.stringBytes > size ||
+            uint32_t(h.states) + h.stackSymbols + h.rules > h.strings || h.start >= h.states || h.trap >= h.states) {
+            err = "Corrupt trace header";
+            return false;
+        }
+        TraceLayout l(h);
+        if (l.end > size) { err = "Truncated trace"; return false; }
+        base = data;
+        flowStart = at<uint64_t>(l.flowStart);
+        flowNameIds = at<uint32_t>(l.flowName);
+        depths = at<uint16_t>(l.depth);
+        labels = at<uint32_t>(l.label);
+        stringStart = at<uint32_t>(l.stringStart);
+        verdicts = at<uint8_t>(l.flowVerdict);
+        states = at<uint8_t>(l.state);
+        symbols = at<uint8_t>(l.symbol);
+        rules = at<uint8_t>(l.rule);
+        flagBits = at<uint8_t>(l.flags);
+        tops = at<uint8_t>(l.top);
+        chars = at<char>(l.text);
+        if (!indexesValid()) {
+            err = "Corrupt trace index";
+            return false;
+        }
+        return true;
+    }
+
+    const TraceHeader& header() const { return h; }
+    uint64_t flows() const { return h.flows; }
+    uint64_t steps() const { return h.steps; }
+
+    // --- PER FLOW ---
+    uint64_t begin(uint64_t f) const { return flowStart[f]; }
+    uint64_t end(uint64_t f) const { return flowStart[f + 1]; }
+    std::string_view flowName(uint64_t f) const { return text(flowNameIds[f]); }
+    Verdict verdict(uint64_t f) const { return Verdict(verdicts[f]); }
+
+    // --- PER STEP ---
+    uint8_t state(uint64_t i) const { return states[i]; }
+    Symbol symbol(uint64_t i) const { return Symbol(symbols[i]); }
+    uint8_t rule(uint64_t i) const { return rules[i]; }
+    uint8_t flags(uint64_t i) const { return flagBits[i]; }
+    std::string_view label(uint64_t i) const { return text(labels[i]); }
+    uint32_t labelId(uint64_t i) const { return labels[i]; }
+    TraceFrame frame(uint64_t i) const { return TraceFrame{ states[i], tops[i], depths[i] }; }
+    TraceFrame initial() const { return TraceFrame{ h.start, h.bottom, 1 }; }
+
+    // --- STRING TABLE ---
+    std::string_view text(uint32_t id) const {
+        return std::string_view(chars + stringStart[id], stringStart[id + 1] - stringStart[id]);
+    }
+    std::string_view stateName(uint8_t s) const { return text(s); }
+    std::string_view stackName(uint8_t s) const { return s < h.stackSymbols ? text(h.states + s) : "EMPTY"; }
+    std::string_view ruleName(uint8_t r) const { return text(uint32_t(h.states) + h.stackSymbols + r); }
+    bool isTrap(uint8_t s) const { return s == h.trap; }
+
+private:
+    MappedFile file;
+    TraceHeader h{};
+    const uint8_t* base = nullptr;
+    const uint64_t* flowStart = nullptr;
+    const uint32_t* flowNameIds = nullptr;
+    const uint16_t* depths = nullptr;
+    const uint32_t* labels = nullptr;
+    const uint32_t* stringStart = nullptr;
+    const uint8_t* verdicts = nullptr;
+    const uint8_t* states = nullptr;
+    const uint8_t* symbols = nullptr;
+    const uint8_t* rules = nullptr;
+    const uint8_t* flagBits = nullptr;
+    const uint8_t* tops = nullptr;
+    const char* chars = nullptr;
+
+    template <typename T>
+    const T* at(uint64_t offset) const { return reinterpret_cast<const T*>(base + offset); }
+
+    // One pass over the offset tables, flow columns and per-step ids.
+    bool indexesValid() const {
+        if (flowStart[0] != 0 || flowStart[h.flows] != h.steps) return false;
+        if (stringStart[0] != 0 || stringStart[h.strings] != h.stringBytes) return false;
+        for (uint64_t f = 0; f < h.flows; f++)
+            if (flowStart[f] > flowStart[f + 1] || flowNameIds[f] >= h.strings || verdicts[f] >= VERDICT_COUNT) return false;
+        for (uint32_t i = 0; i < h.strings; i++)
+            if (stringStart[i] > stringStart[i + 1]) return false;
+        for (uint64_t i = 0; i < h.steps; i++)
+            if (labels[i] >= h.strings || states[i] >= h.states || rules[i] >= h.rules) return false;
+        return true;
+    }
+};
@@ -1,10 +1,16 @@
 import customtkinter as ctk
 import tkinter as tk
+from tkinter import filedialog
 import subprocess
 import threading
+import queue
 import json
+import ctypes
+import mmap
+import struct
 import sys
 import os
+import time
 
 # CONFIGURATION
 ctk.set_appearance_mode("Dark")
@@ -13,6 +19,281 @@ ctk.set_default_color_theme("blue")
 CPP_EXECUTABLE = "./pda_json" 
 if sys.platform == "win32": CPP_EXECUTABLE = "pda_json.exe"
 
+# In-process engine (see libpda.h); without it the GUI falls back to pda_json
+LIBPDA = os.path.join(os.path.dirname(os.path.abspath(__file__)), "pda.dll" if sys.platform == "win32" else "libpda.so")
+
+# pda_json streams events as fast as it can; the pause before each event
+# type (seconds) is applied here so the animation stays watchable
+PACING = {"packet_start": 0.8, "step": 0.6}
+
+class PdaWorker:
+    """One long-lived "pda_json --worker" process shared by every request.
+
+    A request is one line, "<id> <scenario number | packet labels>"; every event
+    of its answer carries the id. A reader thread routes the events to the
+    queue of their request, so any number of requests can be in flight."""
+
+    def __init__(self, exe=CPP_EXECUTABLE):
+        self.exe = exe
+        self.proc = None
+        self.queues = {}
+        self.next_id = 0
+        self.lock = threading.Lock()
+
+    def submit(self, body):
+        """Send a request; its events arrive on the returned queue, then None."""
+        with self.lock:
+            if self.proc is None or self.proc.poll() is not None:
+                # bufsize=1 enables line-buffering for real-time updates
+                self.proc = subprocess.Popen([self.exe, "--worker"], stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True, bufsize=1)
+                threading.Thread(target=self._read, args=(self.proc,), daemon=True).start()
+            self.next_id += 1
+            rid = f"r{self.next_id}"
+            q = queue.Queue()
+            self.queues[rid] = q
+            self.proc.stdin.write(f"{rid} {body}\n")
+            self.proc.stdin.flush()
+        return q
+
+    def run(self, body):
+        """Blocking form for scripts: every event of one request."""
+        q = self.submit(body)
+        events = []
+        while True:
+            data = q.get()
+            if data is None: return events
+            events.append(data)
+
+    def close(self):
+        if self.proc and self.proc.poll() is None:
+            self.proc.stdin.close()
+            self.proc.wait()
+
+    def _read(self, proc):
+        for line in proc.stdout:
+            try:
+                data = json.loads(line)
+            except json.JSONDecodeError: continue
+            last = data['type'] in ("done", "error")
+            with self.lock:
+                q = self.queues.pop(data['id'], None) if last else self.queues.get(data['id'])
+            if q is None: continue
+            q.put(data)
+            if last: q.put(None)
+        # The worker is gone: release whoever still waits on it
+        with self.lock:
+            if self.proc is not proc: return
+            pending, self.queues = self.queues, {}
+        for q in pending.values(): q.put(None)
+
+class PdaStep(ctypes.Structure):
+    _fields_ = [("state", ctypes.c_uint8), ("stack_top", ctypes.c_uint8), ("flags", ctypes.c_uint8),
+                ("reserved", ctypes.c_uint8), ("rule", ctypes.c_uint16), ("depth", ctypes.c_uint16)]
+
+PDA_ABI_VERSION = 1
+PDA_STEP_ATTACK = 0x01
+
+class PdaLibrary:
+    """The engine loaded in-process through libpda's C ABI.
+
+    Symbols and steps live in ctypes arrays the library reads and fills in
+    place; run() turns them into the same events pda_json would print."""
+
+    def __init__(self, path=LIBPDA, definition=None):
+        lib = ctypes.CDLL(path)
+        u8p, size = ctypes.POINTER(ctypes.c_uint8), ctypes.c_size_t
+        handle = ctypes.c_void_p
+        lib.pda_abi_version.restype = ctypes.c_int
+        lib.pda_open.argtypes = [ctypes.c_char_p, ctypes.c_char_p, size]
+        lib.pda_open.restype = handle
+        lib.pda_close.argtypes = [handle]
+        lib.pda_classify_batch.argtypes = [ctypes.c_char_p, size, u8p, size]
+        lib.pda_classify_batch.restype = size
+        lib.pda_initial.argtypes = [handle, ctypes.POINTER(PdaStep)]
+        lib.pda_run.argtypes = [handle, u8p, size, ctypes.POINTER(PdaStep)]
+        lib.pda_run.restype = size
+        lib.pda_validate.argtypes = [handle, u8p, ctypes.POINTER(ctypes.c_uint32), size, u8p]
+        for name in ("pda_state_name", "pda_stack_label", "pda_rule_desc", "pda_rule_analysis"):
+            getattr(lib, name).argtypes = [handle, size]
+            getattr(lib, name).restype = ctypes.c_char_p
+        lib.pda_scenario_count.restype = ctypes.c_int
+        for name in ("pda_scenario_name", "pda_scenario_packets"):
+            getattr(lib, name).argtypes = [ctypes.c_int]
+            getattr(lib, name).restype = ctypes.c_char_p
+        if lib.pda_abi_version() != PDA_ABI_VERSION:
+            raise OSError(f"{path}: ABI version {lib.pda_abi_version()}, expected {PDA_ABI_VERSION}")
+
+        err = ctypes.create_string_buffer(256)
+        self.handle = lib.pda_open(definition.encode() if definition else None, err, len(err))
+        if not self.handle: raise OSError(err.value.decode())
+        self.lib = lib
+        self.streams = 0
+        # Reused buffers, grown on demand
+        self.syms = (ctypes.c_uint8 * 64)()
+        self.steps = (PdaStep * 64)()
+
+    def _text(self, fn, i):
+        return fn(self.handle, i).decode()
+
+    def classify(self, labels):
+        """Whitespace-separated labels -> symbols, in self.syms; returns the count."""
+        raw = labels.encode()
+        n = self.lib.pda_classify_batch(raw, len(raw), self.syms, len(self.syms))
+        if n > len(self.syms):
+            self.syms = (ctypes.c_uint8 * n)()
+            self.steps = (PdaStep * n)()
+            self.lib.pda_classify_batch(raw, len(raw), self.syms, n)
+        return n
+
+    def validate(self, streams):
+        """Final verdicts (PDA_VERDICT_*) of many packet streams in one call."""
+        syms, offsets = bytearray(), [0]
+        for labels in streams:
+            n = self.classify(labels)
+            syms += bytes(self.syms[:n])
+            offsets.append(len(syms))
+        buf = (ctypes.c_uint8 * max(len(syms), 1)).from_buffer(syms if syms else bytearray(1))
+        verdicts = (ctypes.c_uint8 * len(streams))()
+        self.lib.pda_validate(self.handle, buf, (ctypes.c_uint32 * len(offsets))(*offsets), len(streams), verdicts)
+        return list(verdicts)
+
+    def run(self, body):
+        """Events of one request (scenario number or packet labels), as pda_json emits them."""
+        body = str(body).strip()
+        if body.isdigit():
+            sid = int(body)
+            if not 1 <= sid <= self.lib.pda_scenario_count():
+                return [self._event("error", "", 0, "", f"Unknown scenario {body}.", "Scenarios are numbered 1 to 4.", False)]
+            name, labels = self.lib.pda_scenario_name(sid).decode(), self.lib.pda_scenario_packets(sid).decode()
+        elif body:
+            self.streams += 1
+            name, labels = f"Stream {self.streams}", body
+        else:
+            return [self._event("error", "", 0, "", "Empty request.", "Expected a scenario number or packet labels.", False)]
+
+        packets = labels.split()
+        n = self.classify(labels)
+        init = PdaStep()
+        self.lib.pda_initial(self.handle, ctypes.byref(init))
+        done = self.lib.pda_run(self.handle, self.syms, n, self.steps)
+
+        events = [self._event("init", "", init.state, self._text(self.lib.pda_stack_label, init.stack_top), f"Loaded: {name}", "Ready to analyze.", False)]
+        prev = init
+        for pkt, st in zip(packets, self.steps[:done]):
+            events.append(self._event("packet_start", pkt, prev.state, self._text(self.lib.pda_stack_label, prev.stack_top),
+                                      f"Processing {pkt}...", f"Packet arriving at state q{prev.state}", False))
+            events.append(self._event("step", pkt, st.state, self._text(self.lib.pda_stack_label, st.stack_top),
+                                      self._text(self.lib.pda_rule_desc, st.rule), self._text(self.lib.pda_rule_analysis, st.rule),
+                                      bool(st.flags & PDA_STEP_ATTACK)))
+            prev = st
+        events.append(self._event("done", "", prev.state, "", "Simulation Complete", "End of stream.", False))
+        return events
+
+    def submit(self, body):
+        """Same contract as PdaWorker.submit: a queue of events ending in None."""
+        q = queue.Queue()
+        for data in self.run(body): q.put(data)
+        q.put(None)
+        return q
+
+    def close(self):
+        if self.handle: self.lib.pda_close(self.handle)
+        self.handle = None
+
+    @staticmethod
+    def _event(kind, pkt, state, stack_top, desc, analysis, attack):
+        return {"type": kind, "packet": pkt, "state": state, "stackTop": stack_top,
+                "desc": desc, "analysis": analysis, "isAttack": attack}
+
+class PdaTrace:
+    """A .pdatrace file (PDACore/pda_trace.h), written by "CaptureValidator --trace".
+
+    The file is mapped read-only and every column is a memoryview cast over the
+    mapping, so opening a trace of millions of steps reads only its header.
+    run() turns one flow's rows into the events pda_json would print."""
+
+    HEADER = struct.Struct("<8sIIQQQ6B18x")
+    VERDICTS = ("SUCCESS", "ALERT", "WARN", "OVERFLOW")
+    FLAG_ATTACK = 0x04
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        (magic, version, strings, flows, steps, text_bytes, self.states, self.stack_syms, self.rules,
+         self.start, self.bottom, self.trap) = self.HEADER.unpack_from(self.map)
+        if magic != b"PDATRAC1" or version != 1:
+            raise OSError(f"{path}: not a version 1 PDA trace")
+        self.flows, self.steps = flows, steps
+        view = memoryview(self.map)
+        at = self.HEADER.size
+        def column(fmt, count):
+            # Same layout rule as TraceLayout: every section 8-byte aligned
+            nonlocal at
+            size = struct.calcsize(fmt) * count
+            if at + size > len(self.map):
+                raise OSError(f"{path}: truncated or corrupt PDA trace")
+            col = view[at:at + size].cast(fmt)
+            at = (at + size + 7) & ~7
+            return col
+        self.flow_start = column("Q", flows + 1)
+        self.flow_name = column("I", flows)
+        self.depth = column("H", steps)
+        self.label = column("I", steps)
+        self.string_start = column("I", strings + 1)
+        self.verdict = column("B", flows)
+        self.state = column("B", steps)
+        self.symbol = column("B", steps)
+        self.rule = column("B", steps)
+        self.flags = column("B", steps)
+        self.top = column("B", steps)
+        self.text_bytes = column("B", text_bytes)
+        if self.flow_start[0] != 0 or self.flow_start[flows] != steps or self.string_start[strings] != text_bytes:
+            raise OSError(f"{path}: truncated or corrupt PDA trace")
+
+    def text(self, i):
+        return bytes(self.text_bytes[self.string_start[i]:self.string_start[i + 1]]).decode()
+
+    def state_name(self, s): return self.text(s)
+    def stack_name(self, s): return self.text(self.states + s) if s < self.stack_syms else "EMPTY"
+    def rule_name(self, r): return self.text(self.states + self.stack_syms + r)
+    def flow_title(self, f): return self.text(self.flow_name[f])
+
+    def run(self, body):
+        """Events of flow number `body` (1-based), as pda_json emits them."""
+        body = str(body).strip()
+        if not body.isdigit() or not 1 <= int(body) <= self.flows:
+            return [PdaLibrary._event("error", "", 0, "", f"Unknown flow {body}.", f"Flows are numbered 1 to {self.flows}.", False)]
+        f = int(body) - 1
+        name = self.flow_title(f)
+        events = [PdaLibrary._event("init", "", self.start, self.stack_name(self.bottom), f"Loaded: {name}",
+                                    f"{self.flow_start[f + 1] - self.flow_start[f]} recorded steps.", False)]
+        state, top = self.start, self.bottom
+        for i in range(self.flow_start[f], self.flow_start[f + 1]):
+            pkt = self.text(self.label[i])
+            events.append(PdaLibrary._event("packet_start", pkt, state, self.stack_name(top), f"Processing {pkt}...",
+                                            f"Packet arriving at state {self.state_name(state)}", False))
+            rule, prev, state, top = self.rule_name(self.rule[i]), state, self.state[i], self.top[i]
+            events.append(PdaLibrary._event("step", pkt, state, self.stack_name(top), rule,
+                                            f"Rule {rule}: {self.state_name(prev)} -> {self.state_name(state)}, "
+                                            f"stack top {self.stack_name(top)} (depth {self.depth[i]}).",
+                                            bool(self.flags[i] & self.FLAG_ATTACK)))
+        events.append(PdaLibrary._event("done", "", state, "", "Simulation Complete", f"Verdict: {self.VERDICTS[self.verdict[f]]}", False))
+        return events
+
+    def submit(self, body):
+        """Same contract as PdaWorker.submit: a queue of events ending in None."""
+        q = queue.Queue()
+        for data in self.run(body): q.put(data)
+        q.put(None)
+        return q
+
+def open_engine():
+    """libpda in-process when it is built, else one pda_json worker."""
+    try:
+        return PdaLibrary()
+    except OSError:
+        return PdaWorker()
+
 class ModernPDA(ctk.CTk):
     def __init__(self):
         super().__init__()
@@ -43,11 +324,20 @@ class ModernPDA(ctk.CTk):
         self.btn_4 = ctk.CTkButton(self.sidebar, text="4. Nmap Scan", fg_color="#D32F2F", hover_color="#B71C1C", command=lambda: self.run_cpp(4))
         self.btn_4.grid(row=4, column=0, padx=20, pady=8)
 
+        # Recorded flows (CaptureValidator --trace)
+        self.btn_trace = ctk.CTkButton(self.sidebar, text="Open Trace...", fg_color="#555", hover_color="#333", command=self.open_trace)
+        self.btn_trace.grid(row=5, column=0, padx=20, pady=8)
+
         # Log Box
         self.lbl_log = ctk.CTkLabel(self.sidebar, text="Action Log:", anchor="w")
-        self.lbl_log.grid(row=5, column=0, padx=20, pady=(20,0), sticky="w")
+        self.lbl_log.grid(row=6, column=0, padx=20, pady=(20,0), sticky="w")
         self.console = ctk.CTkTextbox(self.sidebar, width=180, height=250)
-        self.console.grid(row=6, column=0, padx=10, pady=5)
+        self.console.grid(row=7, column=0, padx=10, pady=5)
+
+        # Pacing toggle (off = show the result of the whole run at once)
+        self.animate = ctk.BooleanVar(value=True)
+        self.sw_animate = ctk.CTkSwitch(self.sidebar, text="Animate", variable=self.animate)
+        self.sw_animate.grid(row=8, column=0, padx=20, pady=(5, 10), sticky="w")
 
         # === RIGHT AREA (Visualization) ===
         self.vis_frame = ctk.CTkFrame(self, fg_color="#1a1a1a")
@@ -79,6 +369,15 @@ class ModernPDA(ctk.CTk):
         
         self.draw_scene()
 
+        # One engine (libpda in-process, or a pda_json worker) serves every click
+        self.worker = open_engine()
+        self.run_token = 0
+        self.protocol("WM_DELETE_WINDOW", self.on_close)
+
+    def on_close(self):
+        self.worker.close()
+        self.destroy()
+
     def draw_scene(self):
         # Draw Stack Box (Background)
         self.canvas.create_text(700, 180, text="STACK MEMORY", fill="#aaa", font=("Roboto", 10))
@@ -138,7 +437,8 @@ class ModernPDA(ctk.CTk):
         
         active_col = "#1f538d" # Blue
         if is_attack: active_col = "#D32F2F" # Red
-        self.canvas.itemconfig(self.nodes[state], fill=active_col, outline="white")
+        # Traces of other definitions have states the diagram does not draw
+        if state in self.nodes: self.canvas.itemconfig(self.nodes[state], fill=active_col, outline="white")
 
         # 3. Stack Visualization (UPDATED LOGIC)
         # We now check if "S" is present in the string, handling "S" or "Session Token"
@@ -157,7 +457,7 @@ class ModernPDA(ctk.CTk):
         if self.packet_obj: self.canvas.delete(self.packet_obj)
         if self.packet_text_obj: self.canvas.delete(self.packet_text_obj)
 
-        if pkt:
+        if pkt and state in self.nodes:
             pos = self.canvas.coords(self.nodes[state])
             px, py = (pos[0]+pos[2])/2, (pos[1]+pos[3])/2
             
@@ -173,29 +473,42 @@ class ModernPDA(ctk.CTk):
             self.canvas.tag_raise(self.packet_obj)
             self.canvas.tag_raise(self.packet_text_obj)
 
-    def run_cpp(self, scenario_id):
+    def open_trace(self):
+        path = filedialog.askopenfilename(filetypes=[("PDA trace", "*.pdatrace"), ("All files", "*")])
+        if not path: return
+        try:
+            trace = PdaTrace(path)
+        except (OSError, ValueError, struct.error) as e:
+            self.console.insert("end", f"Error: {e}\n")
+            return
+        flow = ctk.CTkInputDialog(text=f"{trace.flows} flows, {trace.steps} steps.\nFlow to replay (1-{trace.flows}):", title="Open Trace").get_input()
+        if flow: self.run_cpp(flow, trace)
+
+    def run_cpp(self, scenario_id, engine=None):
         # Clear packet visual on new run
         if self.packet_obj: self.canvas.delete(self.packet_obj)
         if self.packet_text_obj: self.canvas.delete(self.packet_text_obj)
-        threading.Thread(target=self._thread_target, args=(scenario_id,), daemon=True).start()
+        # A newer click takes over the display from a run still animating
+        self.run_token += 1
+        threading.Thread(target=self._thread_target, args=(engine or self.worker, scenario_id, self.animate.get(), self.run_token), daemon=True).start()
 
-    def _thread_target(self, scenario_id):
+    def _thread_target(self, engine, scenario_id, animate, token):
         try:
-            # bufsize=1 enables line-buffering for real-time updates
-            proc = subprocess.Popen([CPP_EXECUTABLE], stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, bufsize=1)
-            proc.stdin.write(f"{scenario_id}\n")
-            proc.stdin.flush()
-
-            for line in proc.stdout:
-                if not line: break
-                try:
-                    data = json.loads(line.strip())
-                    self.after(0, self.update_ui, data)
-                except json.JSONDecodeError: pass
-
-            proc.wait()
-        except FileNotFoundError:
+            events = engine.submit(scenario_id)
+        except (FileNotFoundError, OSError):
             self.after(0, lambda: self.console.insert("end", "Error: C++ Executable not found. Compile pda_json.cpp first.\n"))
+            return
+
+        while True:
+            data = events.get()
+            if data is None or token != self.run_token: break
+            if data['type'] == 'error':
+                self.after(0, lambda d=data: self.console.insert("end", f"Error: {d['desc']}\n"))
+                continue
+            if animate:
+                time.sleep(PACING.get(data['type'], 0))
+            if token != self.run_token: break
+            self.after(0, self.update_ui, data)
 
 if __name__ == "__main__":
     app = ModernPDA()
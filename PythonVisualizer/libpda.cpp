@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "pda_gui.h"
+#include "libpda.h"
+
+using namespace std;
+
+static_assert(PDA_SYM_INVALID == SYM_INVALID && PDA_SYM_COUNT == SYM_COUNT, "libpda.h symbols follow pda_symbols.h");
+
+// The handle is the compiled table plus the GUI narration of its rules
+struct pda_handle {
+    PdaTable protocol;
+    vector<RuleText> ruleText;
+};
+
+namespace {
+
+pda_step makeStep(const pda_handle* h, const PdaConfig& pda, uint16_t rule, uint8_t flags) {
+    pda_step s;
+    s.state = pda.state;
+    s.stack_top = h->protocol.top(pda);
+    s.flags = flags;
+    s.reserved = 0;
+    s.rule = rule;
+    s.depth = uint16_t(pda.depth());
+    return s;
+}
+
+// Caller bytes past the alphabet are SYM_INVALID, never table indices
+Symbol inputOf(uint8_t b) { return b < SYM_COUNT ? Symbol(b) : SYM_INVALID; }
+
+template <typename T>
+const char* nameAt(const vector<T>& names, size_t id) {
+    return id < names.size() ? names[id].c_str() : nullptr;
+}
+
+} // namespace
+
+extern "C" {
+
+int pda_abi_version(void) { return PDA_ABI_VERSION; }
+
+pda_handle* pda_open(const char* definition_path, char* err, size_t err_len) {
+    pda_handle* h = new pda_handle;
+    string msg;
+    if (!h->protocol.load(definition_path ? definition_path : "", msg)) {
+        if (err && err_len) snprintf(err, err_len, "%s", msg.c_str());
+        delete h;
+        return nullptr;
+    }
+    h->ruleText = guiRuleText(h->protocol);
+    return h;
+}
+
+void pda_close(pda_handle* h) { delete h; }
+
+// --- Packet labels -> input symbols ---
+uint8_t pda_classify(const char* label, size_t len) { return classifyPacket(string_view(label, len)); }
+
+size_t pda_classify_batch(const char* text, size_t len, uint8_t* syms, size_t cap) {
+    size_t count = 0, i = 0;
+    while (i < len) {
+        while (i < len && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r' || text[i] == '\n')) i++;
+        size_t b = i;
+        while (i < len && !(text[i] == ' ' || text[i] == '\t' || text[i] == '\r' || text[i] == '\n')) i++;
+        if (i == b) break;
+        if (count < cap) syms[count] = classifyPacket(string_view(text + b, i - b));
+        count++;
+    }
+    return count;
+}
+
+// --- Running ---
+void pda_initial(const pda_handle* h, pda_step* out) {
+    PdaConfig pda;
+    h->protocol.reset(pda);
+    *out = makeStep(h, pda, 0xFFFF, 0);
+}
+
+size_t pda_run(const pda_handle* h, const uint8_t* syms, size_t n, pda_step* steps) {
+    PdaConfig pda;
+    h->protocol.reset(pda);
+    for (size_t i = 0; i < n; i++) {
+        PdaTransition t = h->protocol.step(pda, inputOf(syms[i]));
+        bool attack = h->protocol.isTrap(pda.state);
+        steps[i] = makeStep(h, pda, t.rule, uint8_t((attack ? PDA_STEP_ATTACK : 0) | (pda.overflow ? PDA_STEP_OVERFLOW : 0)));
+        if (attack) return i + 1;
+    }
+    return n;
+}
+
+void pda_validate(const pda_handle* h, const uint8_t* syms, const uint32_t* offsets, size_t flows, uint8_t* verdicts) {
+    const Symbol* s = reinterpret_cast<const Symbol*>(syms);
+    for (size_t f = 0; f < flows; f++) {
+        PdaConfig pda;
+        h->protocol.reset(pda);
+        // Runs of valid symbols go through the fast path, each bad byte steps as SYM_INVALID
+        for (size_t i = offsets[f], end = offsets[f + 1]; i < end; i++) {
+            size_t j = i;
+            while (j < end && syms[j] < SYM_COUNT) j++;
+            h->protocol.run(pda, s + i, j - i);
+            i = j;
+            if (i < end) h->protocol.step(pda, SYM_INVALID);
+        }
+        verdicts[f] = h->protocol.verdict(pda);
+    }
+}
+
+// --- Names and narration ---
+size_t pda_state_count(const pda_handle* h) { return h->protocol.states.size(); }
+size_t pda_rule_count(const pda_handle* h) { return h->protocol.rules.size(); }
+const char* pda_state_name(const pda_handle* h, size_t id) { return nameAt(h->protocol.states, id); }
+const char* pda_stack_name(const pda_handle* h, size_t id) { return nameAt(h->protocol.stackSyms, id); }
+const char* pda_rule_name(const pda_handle* h, size_t id) { return nameAt(h->protocol.rules, id); }
+
+const char* pda_stack_label(const pda_handle* h, size_t id) {
+    return id < h->protocol.stackSyms.size() ? stackLabel(h->protocol, uint8_t(id)).data() : nullptr;
+}
+
+const char* pda_rule_desc(const pda_handle* h, size_t id) {
+    return id < h->ruleText.size() ? h->ruleText[id].desc.c_str() : nullptr;
+}
+
+const char* pda_rule_analysis(const pda_handle* h, size_t id) {
+    return id < h->ruleText.size() ? h->ruleText[id].analysis.c_str() : nullptr;
+}
+
+// --- Demo scenarios ---
+int pda_scenario_count(void) { return SCENARIO_COUNT; }
+
+const char* pda_scenario_name(int id) {
+    static const vector<string> names = [] {
+        vector<string> v;
+        for (const Scenario& s : SCENARIOS) v.emplace_back(s.name);
+        return v;
+    }();
+    return id >= 1 && id <= SCENARIO_COUNT ? names[id - 1].c_str() : nullptr;
+}
+
+const char* pda_scenario_packets(int id) {
+    static const vector<string> lists = [] {
+        vector<string> v;
+        for (const Scenario& s : SCENARIOS) {
+            string joined;
+            for (string_view p : s.packets) joined += (joined.empty() ? "" : " ") + string(p);
+            v.push_back(joined);
+        }
+        return v;
+    }();
+    return id >= 1 && id <= SCENARIO_COUNT ? lists[id - 1].c_str() : nullptr;
+}
+
+} // extern "C"
@@ -0,0 +1,103 @@
+#ifndef LIBPDA_H
+#define LIBPDA_H
+/* === LIBPDA: C ABI OF THE PDA ENGINE ===
+ * The engine behind pda_json as a shared library, for callers that want it
+ * in-process (the Python frontend loads it through ctypes). Plain C types
+ * only, an opaque handle, fixed-layout structs and no allocation on behalf
+ * of the caller: batch calls read caller arrays and fill caller buffers.
+ *
+ * Build: g++ -std=gnu++17 -O2 -shared -fPIC -fvisibility=hidden -o libpda.so libpda.cpp
+ *
+ * Strings returned by the library are owned by it and stay valid until the
+ * handle they came from is closed (scenario strings: forever).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define PDA_API __declspec(dllexport)
+#else
+#define PDA_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a signature or struct layout below changes */
+#define PDA_ABI_VERSION 1
+
+typedef struct pda_handle pda_handle;
+
+/* One packet's outcome, 8 bytes */
+typedef struct {
+    uint8_t state;        /* state after the packet */
+    uint8_t stack_top;    /* stack symbol on top after it (pda_stack_name) */
+    uint8_t flags;        /* PDA_STEP_* */
+    uint8_t reserved;
+    uint16_t rule;        /* rule that fired (pda_rule_name, pda_rule_desc) */
+    uint16_t depth;       /* stack depth after it */
+} pda_step;
+
+/* Input symbols: PDA_SYM_INVALID is the last, PDA_SYM_COUNT one past it */
+#define PDA_SYM_INVALID 12
+#define PDA_SYM_COUNT   13
+
+#define PDA_STEP_ATTACK   0x01   /* the packet sent the flow to the trap */
+#define PDA_STEP_OVERFLOW 0x02   /* ... because a push did not fit the stack */
+
+/* Final verdicts, same values as the engine's Verdict */
+#define PDA_VERDICT_SUCCESS  0
+#define PDA_VERDICT_ALERT    1
+#define PDA_VERDICT_WARN     2
+#define PDA_VERDICT_OVERFLOW 3
+
+PDA_API int pda_abi_version(void);
+
+/* Compile a PDA definition file (NULL or "" = built-in TCP handshake). On
+ * failure returns NULL and writes the reason to err (if err_len > 0). */
+PDA_API pda_handle* pda_open(const char* definition_path, char* err, size_t err_len);
+PDA_API void pda_close(pda_handle* h);
+
+/* --- Packet labels -> input symbols --- */
+PDA_API uint8_t pda_classify(const char* label, size_t len);
+/* Whitespace-separated labels in text[0, len) -> syms; returns how many labels
+ * there were (only the first cap are written) */
+PDA_API size_t pda_classify_batch(const char* text, size_t len, uint8_t* syms, size_t cap);
+
+/* --- Running ---
+ * Symbols are pda_classify() values; any byte >= PDA_SYM_COUNT is taken as
+ * PDA_SYM_INVALID (which the built-in definitions send to the trap), so no
+ * input can index past the transition table. */
+/* Initial configuration as a step (rule = 0xFFFF) */
+PDA_API void pda_initial(const pda_handle* h, pda_step* out);
+/* One flow from the start state: steps[i] is the outcome of syms[i]. Stops
+ * after the packet that hits the trap; returns the steps written. */
+PDA_API size_t pda_run(const pda_handle* h, const uint8_t* syms, size_t n, pda_step* steps);
+/* Many flows at once: flow f is syms[offsets[f], offsets[f + 1]). Writes one
+ * PDA_VERDICT_* per flow. */
+PDA_API void pda_validate(const pda_handle* h, const uint8_t* syms, const uint32_t* offsets,
+                          size_t flows, uint8_t* verdicts);
+
+/* --- Names and narration (NULL when the id is out of range) --- */
+PDA_API size_t pda_state_count(const pda_handle* h);
+PDA_API size_t pda_rule_count(const pda_handle* h);
+PDA_API const char* pda_state_name(const pda_handle* h, size_t id);
+PDA_API const char* pda_stack_name(const pda_handle* h, size_t id);
+PDA_API const char* pda_stack_label(const pda_handle* h, size_t id);   /* as the GUI shows it */
+PDA_API const char* pda_rule_name(const pda_handle* h, size_t id);
+PDA_API const char* pda_rule_desc(const pda_handle* h, size_t id);
+PDA_API const char* pda_rule_analysis(const pda_handle* h, size_t id);
+
+/* --- Demo scenarios, numbered from 1 --- */
+PDA_API int pda_scenario_count(void);
+PDA_API const char* pda_scenario_name(int id);
+/* Packet labels separated by single spaces */
+PDA_API const char* pda_scenario_packets(int id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+// === GUI CONTENT ===
+// The demo scenarios and the narration shown for each rule. Shared by
+// pda_json (events as JSON lines over a pipe) and libpda (C ABI, loaded
+// in-process by the Python frontend), so both tell the same story.
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../PDACore/pda_engine.h"
+
+// Description + analysis text for each rule the engine can fire
+struct RuleText { std::string desc; std::string analysis; };
+
+inline std::vector<RuleText> guiRuleText(const PdaTable& protocol) {
+    std::vector<std::string> desc = protocol.ruleTexts({
+        {"handshake",    "Handshake Valid."},
+        {"no_handshake", "VIOLATION: No Handshake."},
+        {"tunnel",       "Traffic Authorized."},
+        {"hijack",       "HIJACK ATTEMPT!"},
+        {"close",        "Session Closed."},
+        {"reset",        "Session Reset."},
+        {"nested_open",  "Nested Tunnel Opened."},
+        {"nested_close", "Nested Tunnel Closed."},
+        {"teardown",     "Teardown."},
+        {"after_close",  "INTRUSION DETECTED."},
+        {"blocked",      "Blocked."},
+    });
+    std::vector<std::string> analysis = protocol.ruleTexts({
+        {"handshake",    "Input SYN matches Start Rule. Pushing Session Token."},
+        {"no_handshake", "Protocol Violation: Traffic must start with SYN."},
+        {"tunnel",       "Valid Traffic inside Secure Tunnel (Token Present)."},
+        {"hijack",       "CRITICAL: State q1 active, but Stack is EMPTY. Context missing."},
+        {"close",        "FIN received. Stack has Token. Closing Tunnel."},
+        {"reset",        "RST received. Stack has Token. Tunnel torn down."},
+        {"nested_open",  "SYN inside the Tunnel. Pushing a Tunnel Token on top."},
+        {"nested_close", "FIN/RST inside a nested Tunnel. Popping its Token."},
+        {"teardown",     "Peer FIN / final ACK after close. No payload, stays in q2."},
+        {"after_close",  "Data received after Connection Closed (q2). Implicit Trap."},
+        {"blocked",      "System in Trap State. Dropping packet."},
+    });
+    std::vector<RuleText> text;
+    for (size_t i = 0; i < desc.size(); i++) text.push_back({desc[i], analysis[i]});
+    return text;
+}
+
+// The GUI expects "S" for the session token
+inline std::string_view stackLabel(const PdaTable& protocol, uint8_t sym) {
+    const std::string& name = protocol.stackName(sym);
+    return name == "SESSION" ? std::string_view("S") : std::string_view(name);
+}
+
+// === SCENARIOS ===
+struct Scenario {
+    std::string_view name;
+    std::vector<std::string_view> packets;
+};
+
+inline const Scenario SCENARIOS[] = {
+    { "Web Browsing (Safe)",     {"SYN", "ACK", "HTTP_GET", "JPG_DATA", "FIN"} },
+    { "SSH Session (Safe)",      {"SYN", "ACK", "SSH_KEY", "ENCRYPT_CMD", "FIN"} },
+    { "Session Hijack (Attack)", {"SYN", "ACK", "SSH_KEY", "FIN", "ROOT_CMD"} },
+    { "Nmap Scan (Attack)",      {"FIN"} },
+};
+constexpr int SCENARIO_COUNT = sizeof(SCENARIOS) / sizeof(SCENARIOS[0]);
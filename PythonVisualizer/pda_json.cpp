@@ -1,130 +1,207 @@
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <string>
-#include <stack>
-#include <thread>
-#include <chrono>
+#include <string_view>
+#include "pda_gui.h"
 
 using namespace std;
 
-// Helper to format JSON with the new "Analysis" field
-void sendJSON(string type, string pkt, int state, string stackTop, string desc, string analysis, bool attack) {
-    // Simple manual JSON formatting
-    cout << "{"
-         << "\"type\": \"" << type << "\", "
-         << "\"packet\": \"" << pkt << "\", "
-         << "\"state\": " << state << ", "
-         << "\"stackTop\": \"" << stackTop << "\", "
-         << "\"desc\": \"" << desc << "\", "
-         << "\"analysis\": \"" << analysis << "\", "
-         << "\"isAttack\": " << (attack ? "true" : "false")
-         << "}" << endl;
-}
+// === NDJSON OUTPUT ===
+// One JSON object per line, appended straight into a reusable buffer and
+// written out in large blocks. Nothing is flushed per event: the buffer goes
+// out when it fills up, when the input has no further request waiting, and at
+// exit. Pacing for the eye is the consumer's business (the Python frontend).
+class NdjsonOut {
+public:
+    ~NdjsonOut() { flush(); }
 
-void runScenario(int id) {
-    vector<string> packets;
-    string name;
-    
-    // DEFINING THE 4 SCENARIOS
-    if(id == 1) { 
-        packets = {"SYN", "ACK", "HTTP_GET", "JPG_DATA", "FIN"}; 
-        name = "Web Browsing (Safe)"; 
+    void raw(string_view s) {
+        if (len + s.size() > sizeof(buf)) flush();
+        if (s.size() > sizeof(buf)) { fwrite(s.data(), 1, s.size(), stdout); return; }
+        memcpy(buf + len, s.data(), s.size());
+        len += s.size();
     }
-    else if(id == 2) { 
-        packets = {"SYN", "ACK", "SSH_KEY", "ENCRYPT_CMD", "FIN"}; 
-        name = "SSH Session (Safe)"; 
+
+    // JSON string body: quotes, backslashes and control bytes escaped
+    void text(string_view s) {
+        static const char HEX[] = "0123456789abcdef";
+        size_t from = 0;
+        for (size_t i = 0; i < s.size(); i++) {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            raw(s.substr(from, i - from));
+            if (c == '"' || c == '\\') {
+                char esc[2] = { '\\', char(c) };
+                raw(string_view(esc, 2));
+            } else {
+                char esc[6] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 15] };
+                raw(string_view(esc, 6));
+            }
+            from = i + 1;
+        }
+        raw(s.substr(from));
     }
-    else if(id == 3) { 
-        packets = {"SYN", "ACK", "SSH_KEY", "FIN", "ROOT_CMD"}; 
-        name = "Session Hijack (Attack)"; 
+
+    void number(unsigned v) {
+        char digits[10];
+        int n = 0;
+        do { digits[sizeof(digits) - ++n] = char('0' + v % 10); v /= 10; } while (v);
+        raw(string_view(digits + sizeof(digits) - n, n));
     }
-    else if(id == 4) { 
-        packets = {"FIN"}; 
-        name = "Nmap Scan (Attack)"; 
+
+    void flush() {
+        if (len) fwrite(buf, 1, len, stdout);
+        len = 0;
+        fflush(stdout);
     }
-    
-    stack<string> mem;
-    mem.push("Z0");
-    int state = 0; // 0=q0, 1=q1, 2=q2, 3=Trap
-    bool hasSession = false;
+
+private:
+    char buf[1 << 16];
+    size_t len = 0;
+};
+
+NdjsonOut out;
+string_view requestId;   // worker mode: echoed in every event of the current request
+
+// Text fields are passed as pieces and written back to back, so messages
+// like "Processing " + pkt + "..." never become temporary strings.
+using Pieces = initializer_list<string_view>;
+
+void sendJSON(const char* type, string_view pkt, int state, string_view stackTop, Pieces desc, Pieces analysis, bool attack) {
+    out.raw("{");
+    if (!requestId.empty()) {
+        out.raw("\"id\": \"");
+        out.text(requestId);
+        out.raw("\", ");
+    }
+    out.raw("\"type\": \"");
+    out.raw(type);
+    out.raw("\", \"packet\": \"");
+    out.text(pkt);
+    out.raw("\", \"state\": ");
+    out.number(unsigned(state));
+    out.raw(", \"stackTop\": \"");
+    out.text(stackTop);
+    out.raw("\", \"desc\": \"");
+    for (string_view p : desc) out.text(p);
+    out.raw("\", \"analysis\": \"");
+    for (string_view p : analysis) out.text(p);
+    out.raw(attack ? "\", \"isAttack\": true}\n" : "\", \"isAttack\": false}\n");
+}
+
+// === PROTOCOL ===
+// Compiled from a PDA definition (built-in TCP handshake unless --pda is given)
+PdaTable protocol;
+
+vector<RuleText> ruleText; // rule id -> text
+
+string_view stackTopLabel(const PdaConfig& pda) { return stackLabel(protocol, protocol.top(pda)); }
+
+void runStream(string_view name, const vector<string_view>& packets) {
+    PdaConfig pda;
+    protocol.reset(pda);
 
     // Send Init
-    sendJSON("init", "", 0, "Z0", "Loaded: " + name, "Ready to analyze.", false);
+    sendJSON("init", "", pda.state, stackTopLabel(pda), {"Loaded: ", name}, {"Ready to analyze."}, false);
+
+    for (string_view pkt : packets) {
+        Symbol sym = classifyPacket(pkt); // Classify once, engine runs on IDs
 
-    for(const string& pkt : packets) {
-        this_thread::sleep_for(chrono::milliseconds(800));
-        
         // 1. Log Packet Arrival
-        sendJSON("packet_start", pkt, state, (mem.empty() ? "EMPTY" : mem.top()), "Processing " + pkt + "...", "Packet arriving at state q" + to_string(state), false);
-        this_thread::sleep_for(chrono::milliseconds(600));
-
-        // 2. Process Logic
-        bool attack = false;
-        string desc = "";
-        string analysis = "";
-
-        // --- PDA LOGIC ENGINE ---
-        
-        // STATE q0 (Listen)
-        if(state == 0) {
-            if(pkt == "SYN") { 
-                state = 1; hasSession = true; mem.push("S"); 
-                desc = "Handshake Valid."; 
-                analysis = "Input SYN matches Start Rule. Pushing Session Token.";
-            }
-            else { 
-                state = 3; attack = true; 
-                desc = "VIOLATION: No Handshake."; 
-                analysis = "Protocol Violation: Traffic must start with SYN.";
-            }
-        }
-        // STATE q1 (Active)
-        else if(state == 1) {
-            if(pkt == "FIN") {
-                if(hasSession) { 
-                    state = 2; hasSession = false; mem.pop(); 
-                    desc = "Session Closed."; 
-                    analysis = "FIN received. Stack has Token. Closing Tunnel.";
-                }
-            } else {
-                if(hasSession) { 
-                    state = 1; 
-                    desc = "Traffic Authorized."; 
-                    analysis = "Valid Traffic inside Secure Tunnel (Token Present).";
-                }
-                else { 
-                    state = 3; attack = true; 
-                    desc = "HIJACK ATTEMPT!"; 
-                    analysis = "CRITICAL: State q1 active, but Stack is EMPTY. Context missing.";
-                }
-            }
-        }
-        // STATE q2 (Closed)
-        else if(state == 2) {
-            state = 3; attack = true; 
-            desc = "INTRUSION DETECTED."; 
-            analysis = "Data received after Connection Closed (q2). Implicit Trap.";
-        }
-        // STATE TRAP
-        else { 
-            state = 3; attack = true; 
-            desc = "Blocked."; 
-            analysis = "System in Trap State. Dropping packet.";
-        }
+        char state[4];
+        int digits = snprintf(state, sizeof(state), "%u", unsigned(pda.state));
+        sendJSON("packet_start", pkt, pda.state, stackTopLabel(pda), {"Processing ", pkt, "..."},
+                 {"Packet arriving at state q", string_view(state, size_t(digits))}, false);
+
+        // 2. Process Logic (PDA LOGIC ENGINE)
+        PdaTransition t = protocol.step(pda, sym);
+        bool attack = protocol.isTrap(pda.state);
 
         // 3. Send Result
-        sendJSON("step", pkt, state, (mem.empty() ? "EMPTY" : mem.top()), desc, analysis, attack);
-        
-        if(state == 3) break;
+        sendJSON("step", pkt, pda.state, stackTopLabel(pda), {ruleText[t.rule].desc}, {ruleText[t.rule].analysis}, attack);
+
+        if (attack) break;
+    }
+
+    sendJSON("done", "", pda.state, "", {"Simulation Complete"}, {"End of stream."}, false);
+}
+
+void runScenario(int id) {
+    static const Scenario NONE;
+    const Scenario& s = id >= 1 && id <= SCENARIO_COUNT ? SCENARIOS[id - 1] : NONE;
+    runStream(s.name, s.packets);
+}
+
+// --- FAST / WORKER MODE ---
+// Every stdin line is a request: a scenario number, or a packet stream given
+// as whitespace-separated labels ("SYN ACK HTTP_GET FIN"). In worker mode the
+// line starts with a request ID ("r7 SYN ACK FIN"), every event of the answer
+// carries it and its "done" (or "error") event ends it. Requests are answered
+// in order, so a client may send many before reading any answer.
+void serve(bool worker) {
+    string line;
+    vector<string_view> tokens, packets;
+    unsigned streams = 0;
+    char name[32];
+    while (getline(cin, line)) {
+        tokens.clear();
+        string_view rest(line);
+        while (!rest.empty()) {
+            size_t b = rest.find_first_not_of(" \t\r");
+            if (b == string_view::npos) break;
+            rest.remove_prefix(b);
+            size_t e = min(rest.find_first_of(" \t\r"), rest.size());
+            tokens.push_back(rest.substr(0, e));
+            rest.remove_prefix(e);
+        }
+        if (tokens.empty()) continue;
+
+        size_t first = 0;
+        if (worker) requestId = tokens[first++];
+        packets.assign(tokens.begin() + first, tokens.end());
+
+        if (packets.empty()) {
+            sendJSON("error", "", 0, "", {"Empty request."}, {"Expected a scenario number or packet labels."}, false);
+        } else if (packets.size() == 1 && packets[0].find_first_not_of("0123456789") == string_view::npos) {
+            int id = atoi(packets[0].data());
+            if (id >= 1 && id <= SCENARIO_COUNT) runScenario(id);
+            else sendJSON("error", "", 0, "", {"Unknown scenario ", packets[0], "."}, {"Scenarios are numbered 1 to 4."}, false);
+        } else {
+            int n = snprintf(name, sizeof(name), "Stream %u", ++streams);
+            runStream(string_view(name, size_t(n)), packets);
+        }
+        // Hand over what is done once no further request is already waiting
+        if (cin.rdbuf()->in_avail() <= 0) out.flush();
     }
-    
-    sendJSON("done", "", state, "", "Simulation Complete", "End of stream.", false);
+    requestId = {};
 }
 
-int main() {
-    int id;
-    if (cin >> id) {
-        runScenario(id);
+int main(int argc, char** argv) {
+    ios::sync_with_stdio(false);
+    string err;
+    if (!protocol.load(pdaPathFromArgs(argc, argv), err)) {
+        cerr << err << endl;
+        return 1;
     }
+    ruleText = guiRuleText(protocol);
+
+    // --fast: one request per line until EOF; --worker: the same with request
+    // IDs, kept running by the GUI and scripts (see serve). Without either a
+    // single scenario number is read.
+    bool fast = false, worker = false;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--fast") fast = true;
+        if (string(argv[i]) == "--worker") worker = true;
+    }
+
+    if (fast || worker) {
+        serve(worker);
+    } else {
+        int id;
+        if (cin >> id) runScenario(id);
+    }
+    out.flush();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,289 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "../PDACore/pda_corpus.h"
+
+using namespace std;
+
+// === TRAFFIC GENERATOR ===
+// Writes a seeded, interleaved packet-event corpus (PDACore/pda_corpus.h) for
+// the CaptureValidator and the benchmarks.
+// Usage: TrafficGenerator <out.pdacorpus> [--events <n>] [--seed <n>] [--concurrency <n>]
+//        [--min-len <n>] [--max-len <n>] [--threads <n>] [--pps <n>]
+//        [--fin-scan <%>] [--data-after-fin <%>] [--spoofed-ack <%>] [--syn-flood <%>]
+// Counts accept K/M/G suffixes ("--events 12G" is about a 100 GB corpus).
+//
+// The corpus is cut into fixed chunks; chunk k is generated from (seed, k)
+// alone, so the file is byte-identical for any thread count. Threads generate
+// chunks in parallel and append them in chunk order.
+
+// === FLOW KINDS ===
+enum FlowKind : uint8_t { FLOW_NORMAL, FLOW_FIN_SCAN, FLOW_DATA_AFTER_FIN, FLOW_SPOOFED_ACK, FLOW_SYN_FLOOD, FLOW_KIND_COUNT };
+const char* const FLOW_KIND_NAMES[FLOW_KIND_COUNT] = { "normal", "FIN scan", "data after FIN", "spoofed ACK", "SYN flood" };
+
+enum CloseStyle : uint8_t { CLOSE_ACTIVE, CLOSE_PASSIVE, CLOSE_RESET };
+
+struct GenConfig {
+    uint64_t events = 10000000;
+    uint64_t seed = 1;
+    uint32_t concurrency = 1024;     // flows open at once inside a chunk
+    uint32_t minLen = 2, maxLen = 20;  // data segments of a normal flow
+    unsigned threads = 0;
+    uint64_t pps = 1000000;          // wire rate the timestamps pretend
+    double attackPct[FLOW_KIND_COUNT] = { 0, 2, 2, 2, 4 };   // [FLOW_NORMAL] unused
+};
+
+const uint32_t CHUNK_EVENTS = 1 << 20;
+
+// splitmix64: tiny state, good enough spread, and trivially seekable per chunk
+struct Rng {
+    uint64_t s;
+    uint64_t next() {
+        uint64_t z = (s += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    uint32_t below(uint32_t n) { return uint32_t((next() >> 32) * n >> 32); }
+};
+
+// One open flow: its script is fixed at start (kind, length, close style) and
+// each segment is produced from the position in it.
+struct OpenFlow {
+    uint64_t id;      // chunk * CHUNK_EVENTS + index in chunk
+    FlowKind kind;
+    CloseStyle close;
+    uint16_t pos, len;
+    uint16_t data;    // data segments (normal / data after FIN)
+};
+
+struct Chunk {
+    vector<CorpusRecord> records;
+    uint64_t flows = 0;
+    uint64_t kinds[FLOW_KIND_COUNT] = {};
+};
+
+OpenFlow startFlow(const GenConfig& cfg, Rng& rng, uint64_t id) {
+    OpenFlow f{};
+    f.id = id;
+    double roll = double(rng.below(1000000)) / 10000.0;
+    f.kind = FLOW_NORMAL;
+    for (int k = 1; k < FLOW_KIND_COUNT; k++) {
+        if (roll < cfg.attackPct[k]) { f.kind = FlowKind(k); break; }
+        roll -= cfg.attackPct[k];
+    }
+    switch (f.kind) {
+    case FLOW_NORMAL:
+    case FLOW_DATA_AFTER_FIN:
+        f.data = uint16_t(cfg.minLen + rng.below(cfg.maxLen - cfg.minLen + 1));
+        f.close = f.kind == FLOW_DATA_AFTER_FIN ? CLOSE_ACTIVE : (rng.below(10) < 8 ? CloseStyle(rng.below(2)) : CLOSE_RESET);
+        f.len = uint16_t(3 + f.data + (f.close == CLOSE_RESET ? 1 : 3) + (f.kind == FLOW_DATA_AFTER_FIN));
+        break;
+    case FLOW_FIN_SCAN:    f.len = uint16_t(1 + rng.below(2)); break;   // probe, maybe the RST reply
+    case FLOW_SPOOFED_ACK: f.len = uint16_t(1 + rng.below(3)); break;   // ACKs out of nowhere
+    case FLOW_SYN_FLOOD:   f.len = 2; break;                            // SYN, SYN+ACK, never completed
+    default: break;
+    }
+    return f;
+}
+
+CorpusRecord nextSegment(OpenFlow& f, Rng& rng) {
+    auto seg = [&](uint8_t flags, CorpusDir dir, uint16_t payload = 0) {
+        return corpusRecord(f.id, flags, dir, payload);
+    };
+    auto dataLen = [&]() { return uint16_t(1 + rng.below(1460)); };
+    uint16_t p = f.pos++;
+
+    switch (f.kind) {
+    case FLOW_FIN_SCAN:
+        return p == 0 ? seg(TCP_FIN, CORPUS_FROM_INITIATOR) : seg(TCP_RST | TCP_ACK, CORPUS_FROM_RESPONDER);
+    case FLOW_SPOOFED_ACK:
+        return seg(rng.below(2) ? TCP_ACK : TCP_PSH | TCP_ACK, CORPUS_FROM_INITIATOR, rng.below(2) ? dataLen() : 0);
+    case FLOW_SYN_FLOOD:
+        return p == 0 ? seg(TCP_SYN, CORPUS_FROM_INITIATOR) : seg(TCP_SYN | TCP_ACK, CORPUS_FROM_RESPONDER);
+    default:
+        break;
+    }
+
+    // Normal conversation: handshake, data both ways, close
+    if (p == 0) return seg(TCP_SYN, CORPUS_FROM_INITIATOR);
+    if (p == 1) return seg(TCP_SYN | TCP_ACK, CORPUS_FROM_RESPONDER);
+    if (p == 2) return seg(TCP_ACK, CORPUS_FROM_INITIATOR);
+    if (p < 3 + f.data) return seg(TCP_PSH | TCP_ACK, CorpusDir(rng.below(2)), dataLen());
+    uint16_t c = uint16_t(p - 3 - f.data);
+    if (f.kind == FLOW_DATA_AFTER_FIN && c == 3) return seg(TCP_PSH | TCP_ACK, CORPUS_FROM_INITIATOR, dataLen());
+    if (f.close == CLOSE_RESET) return seg(TCP_RST | TCP_ACK, CorpusDir(rng.below(2)));
+    CorpusDir first = f.close == CLOSE_ACTIVE ? CORPUS_FROM_INITIATOR : CORPUS_FROM_RESPONDER;
+    CorpusDir second = CorpusDir(!first);
+    if (c == 0) return seg(TCP_FIN | TCP_ACK, first);
+    if (c == 1) return seg(TCP_FIN | TCP_ACK, second);
+    return seg(TCP_ACK, first);
+}
+
+// Shortens f's script to at most `room` segments without cutting it: a
+// conversation loses data segments (keeping handshake and close), an attack
+// loses its tail. False if even that does not fit.
+bool fitFlow(OpenFlow& f, uint64_t room) {
+    if (f.len <= room) return true;
+    if (f.kind == FLOW_NORMAL || f.kind == FLOW_DATA_AFTER_FIN) {
+        uint16_t frame = uint16_t(f.len - f.data);
+        if (room < frame) return false;
+        f.data = uint16_t(room - frame);
+    }
+    f.len = uint16_t(room);
+    return true;
+}
+
+// Chunk k: up to `concurrency` flows open at once, each packet taken from a
+// random open flow. A new flow starts only if its whole script fits the
+// budget next to the open flows' remaining segments (trimmed by fitFlow when
+// it would not), then the chunk drains, so no flow is cut and the chunk never
+// exceeds its budget.
+void generateChunk(const GenConfig& cfg, uint64_t k, uint64_t budget, Chunk& out) {
+    Rng rng{ cfg.seed * 0x2545F4914F6CDD1DULL + k };
+    out.records.clear();
+    out.flows = 0;
+    for (uint64_t& n : out.kinds) n = 0;
+
+    vector<OpenFlow> open;
+    open.reserve(cfg.concurrency);
+    uint64_t pending = 0;
+    uint64_t firstId = k * CHUNK_EVENTS;   // a chunk has fewer flows than events
+    auto admit = [&]() {
+        while (open.size() < cfg.concurrency && out.records.size() + pending < budget) {
+            OpenFlow f = startFlow(cfg, rng, firstId + out.flows);
+            if (!fitFlow(f, budget - out.records.size() - pending)) return;
+            out.flows++;
+            out.kinds[f.kind]++;
+            pending += f.len;
+            open.push_back(f);
+        }
+    };
+    admit();
+    while (!open.empty()) {
+        size_t i = rng.below(uint32_t(open.size()));
+        out.records.push_back(nextSegment(open[i], rng));
+        pending--;
+        if (open[i].pos == open[i].len) {
+            open[i] = open.back();
+            open.pop_back();
+            admit();
+        }
+    }
+}
+
+uint64_t parseCount(const char* s) {
+    char* end;
+    double v = strtod(s, &end);
+    switch (*end) {
+    case 'k': case 'K': v *= 1e3; break;
+    case 'm': case 'M': v *= 1e6; break;
+    case 'g': case 'G': v *= 1e9; break;
+    default: break;
+    }
+    return uint64_t(v);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " <out.pdacorpus> [--events <n>] [--seed <n>] [--concurrency <n>] [--min-len <n>] [--max-len <n>]"
+             << " [--threads <n>] [--pps <n>] [--fin-scan <%>] [--data-after-fin <%>] [--spoofed-ack <%>] [--syn-flood <%>]" << endl;
+        return 1;
+    }
+    GenConfig cfg;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        string a = argv[i];
+        const char* v = argv[i + 1];
+        if (a == "--events") cfg.events = parseCount(v);
+        else if (a == "--seed") cfg.seed = strtoull(v, nullptr, 10);
+        else if (a == "--concurrency") cfg.concurrency = uint32_t(max<uint64_t>(1, parseCount(v)));
+        else if (a == "--min-len") cfg.minLen = uint32_t(parseCount(v));
+        else if (a == "--max-len") cfg.maxLen = uint32_t(parseCount(v));
+        else if (a == "--threads") cfg.threads = unsigned(atoi(v));
+        else if (a == "--pps") cfg.pps = max<uint64_t>(1, parseCount(v));
+        else if (a == "--fin-scan") cfg.attackPct[FLOW_FIN_SCAN] = atof(v);
+        else if (a == "--data-after-fin") cfg.attackPct[FLOW_DATA_AFTER_FIN] = atof(v);
+        else if (a == "--spoofed-ack") cfg.attackPct[FLOW_SPOOFED_ACK] = atof(v);
+        else if (a == "--syn-flood") cfg.attackPct[FLOW_SYN_FLOOD] = atof(v);
+        else { cerr << "Unknown option " << a << endl; return 1; }
+    }
+    double attacks = 0;
+    for (int k = 1; k < FLOW_KIND_COUNT; k++) attacks += cfg.attackPct[k];
+    if (attacks > 100 || cfg.minLen > cfg.maxLen || cfg.maxLen > 60000) {
+        cerr << "Attack shares must add up to at most 100% and min-len <= max-len <= 60000" << endl;
+        return 1;
+    }
+    if (cfg.events > (uint64_t(1) << CORPUS_ID_BITS)) {
+        cerr << "At most 2^" << CORPUS_ID_BITS << " events: flow ids would repeat" << endl;
+        return 1;
+    }
+    if (!cfg.threads) cfg.threads = max(1u, thread::hardware_concurrency());
+
+    FILE* out = fopen(argv[1], "wb");
+    if (!out) { cerr << "Cannot create " << argv[1] << endl; return 1; }
+
+    CorpusHeader h{};
+    memcpy(h.magic, CORPUS_MAGIC, sizeof(h.magic));
+    h.version = CORPUS_VERSION;
+    h.recordSize = sizeof(CorpusRecord);
+    h.seed = cfg.seed;
+    h.startNanos = 1700000000ULL * 1000000000ULL;
+    h.intervalNanos = uint32_t(max<uint64_t>(1, 1000000000ULL / cfg.pps));
+    h.chunkEvents = CHUNK_EVENTS;
+    fwrite(&h, sizeof(h), 1, out);   // rewritten with the totals at the end
+
+    // Worker t generates chunks t, t + T, t + 2T, ...; chunk k is written once
+    // chunks 0 .. k-1 are, so the output order never depends on timing.
+    uint64_t chunks = (cfg.events + CHUNK_EVENTS - 1) / CHUNK_EVENTS;
+    uint64_t nextToWrite = 0, events = 0, flows = 0, kinds[FLOW_KIND_COUNT] = {};
+    bool writeFailed = false;
+    mutex m;
+    condition_variable turn;
+
+    auto t0 = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (unsigned t = 0; t < cfg.threads; t++) {
+        workers.emplace_back([&, t] {
+            Chunk c;
+            for (uint64_t k = t; k < chunks; k += cfg.threads) {
+                generateChunk(cfg, k, min<uint64_t>(CHUNK_EVENTS, cfg.events - k * CHUNK_EVENTS), c);
+                unique_lock<mutex> lock(m);
+                turn.wait(lock, [&] { return nextToWrite == k; });
+                if (fwrite(c.records.data(), sizeof(CorpusRecord), c.records.size(), out) != c.records.size()) writeFailed = true;
+                events += c.records.size();
+                flows += c.flows;
+                for (int i = 0; i < FLOW_KIND_COUNT; i++) kinds[i] += c.kinds[i];
+                nextToWrite++;
+                turn.notify_all();
+            }
+        });
+    }
+    for (thread& w : workers) w.join();
+
+    h.events = events;
+    h.flows = flows;
+    fseek(out, 0, SEEK_SET);
+    fwrite(&h, sizeof(h), 1, out);
+    if (fclose(out) != 0 || writeFailed) { cerr << "Write to " << argv[1] << " failed" << endl; return 1; }
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+    double bytes = double(sizeof(CorpusHeader) + events * sizeof(CorpusRecord));
+    cout << "===========================================================" << endl;
+    cout << " CORPUS: " << argv[1] << " (seed " << cfg.seed << ")" << endl;
+    cout << "===========================================================" << endl;
+    cout << "Events:       " << events << " (" << fixed << setprecision(2) << bytes / 1e9 << " GB)" << endl;
+    cout << "Flows:        " << flows << endl;
+    for (int i = 0; i < FLOW_KIND_COUNT; i++)
+        cout << "  " << left << setw(16) << FLOW_KIND_NAMES[i] << right << setw(12) << kinds[i] << endl;
+    cout << "Generated in: " << setprecision(3) << sec << " s (" << setprecision(2) << bytes / 1e9 / sec
+         << " GB/s, " << cfg.threads << " threads)" << endl;
+    return 0;
+}